@@ -0,0 +1,5 @@
+Import("env")
+
+# TLS session resumption (src/tls_session.cpp) hands the cached session to mbedTLS from a wrapper of
+# mbedtls_ssl_set_hostname, the last call WiFiClientSecure makes before the handshake
+env.Append(LINKFLAGS=["-Wl,--wrap=mbedtls_ssl_set_hostname"])
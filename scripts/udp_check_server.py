@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Local stand-in for the UDP update-check server (firmware built with -D USE_UDP_CHECK).
+
+Answers every authenticated check request with the configured timestamp and sleep time,
+so the UDP path can be tried without the real backend:
+
+    python3 scripts/udp_check_server.py --api-key 12345678 --timestamp 1700000000 --sleep 120
+
+and build the firmware with -D UDP_CHECK_HOST=\\"<this machine's IP>\\".
+
+Datagram layout (little endian), see src/udp_check.cpp:
+  request: "ZO", version 1, type 1, nonce u32, MAC[6], timestamp u64, vcc mV u16, RSSI i8, reserved u8, tag[16]
+  reply:   "ZO", version 1, type 2, nonce u32, flags u8, reserved[3], timestamp u64, sleep s u32, tag[16]
+  tag = HMAC-SHA256(key = API key in decimal, everything before the tag)[:16]
+  flags bit 0 = device has to use HTTPS for this wake
+"""
+
+import argparse
+import hashlib
+import hmac
+import socket
+import struct
+import time
+
+MAGIC = b"ZO"
+VERSION = 1
+TYPE_REQUEST = 1
+TYPE_REPLY = 2
+FLAG_HTTPS_REQUIRED = 0x01
+TAG_SIZE = 16
+
+REQUEST = struct.Struct("<2sBBI6sQHbB")
+REPLY = struct.Struct("<2sBBIB3sQI")
+
+
+def tag(key, data):
+    return hmac.new(key, data, hashlib.sha256).digest()[:TAG_SIZE]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=5683)
+    parser.add_argument("--api-key", required=True, help="device API key (X-API-Key value)")
+    parser.add_argument("--timestamp", type=int, default=int(time.time()), help="current content timestamp")
+    parser.add_argument("--sleep", type=int, default=0, help="sleep seconds to send, 0 = device default")
+    parser.add_argument("--https", action="store_true", help="ask devices to continue over HTTPS")
+    parser.add_argument("--drop", type=int, default=0, help="ignore the first N requests (timeout test)")
+    args = parser.parse_args()
+
+    key = args.api_key.encode()
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    print(f"Listening on {args.bind}:{args.port}, timestamp {args.timestamp}")
+
+    dropped = 0
+    while True:
+        data, peer = sock.recvfrom(512)
+        if len(data) != REQUEST.size + TAG_SIZE:
+            print(f"{peer}: unexpected size {len(data)}")
+            continue
+
+        body, received_tag = data[:-TAG_SIZE], data[-TAG_SIZE:]
+        magic, version, kind, nonce, mac, timestamp, vcc, rssi, _ = REQUEST.unpack(body)
+        if magic != MAGIC or version != VERSION or kind != TYPE_REQUEST:
+            print(f"{peer}: not a check request")
+            continue
+        if not hmac.compare_digest(tag(key, body), received_tag):
+            print(f"{peer}: bad tag (wrong API key?)")
+            continue
+
+        print(f"{peer}: MAC {mac.hex(':')}, timestamp {timestamp}, {vcc} mV, {rssi} dBm")
+        if dropped < args.drop:
+            dropped += 1
+            print("  dropped")
+            continue
+
+        flags = FLAG_HTTPS_REQUIRED if args.https else 0
+        reply = REPLY.pack(MAGIC, VERSION, TYPE_REPLY, nonce, flags, b"\0\0\0", args.timestamp, args.sleep)
+        sock.sendto(reply + tag(key, reply), peer)
+        print(f"  {'unchanged' if timestamp == args.timestamp and not flags else 'changed'}")
+
+
+if __name__ == "__main__":
+    main()
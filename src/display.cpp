@@ -454,6 +454,29 @@ uint16_t getResolutionY() { return DISPLAY_RESOLUTION_Y; }
 
 uint16_t getNumberOfPages() { return display.pages(); }
 
+bool getPageRows(uint16_t page, uint16_t &firstRow, uint16_t &rowCount)
+{
+#ifdef USE_EPDIY_DRIVER
+  return false; // Full framebuffer, always a single page
+#else
+  uint16_t pages = display.pages();
+  uint8_t rotation = display.getRotation();
+  if (pages <= 1 || page >= pages || (rotation & 1))
+    return false;
+
+  uint16_t height = display.height();
+  uint16_t pageStart = page * display.pageHeight();
+  uint16_t pageEnd = pageStart + display.pageHeight();
+  if (pageEnd > height)
+    pageEnd = height;
+
+  // Pages always run top to bottom in panel coordinates, 180° rotation takes them from the bottom of the image
+  firstRow = (rotation == 2) ? height - pageEnd : pageStart;
+  rowCount = pageEnd - pageStart;
+  return true;
+#endif
+}
+
 void initM5()
 {
 #ifdef M5StackCoreInk
@@ -233,6 +233,10 @@ inline const char *getColorType() { return COLOR_TYPE_STRING; }
 inline const char *getDisplayType() { return DISPLAY_TYPE_STRING; }
 uint16_t getNumberOfPages();
 
+// Image rows drawn into the given page (respects 180° rotation)
+// Returns false when the whole image is needed (single page, or 90° rotation where pages are image columns)
+bool getPageRows(uint16_t page, uint16_t &firstRow, uint16_t &rowCount);
+
 // M5Stack specific
 void initM5();
 void powerOffM5();
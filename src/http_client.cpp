@@ -3,19 +3,145 @@
 #include "board.h"
 #include "sensor.h"
 #include "display.h"
+#include "image_handler.h"
 #include "logger.h"
+#include "pixel_packer.h"
 #include "state_manager.h"
+#include "tls_session.h"
+#include "udp_check.h"
+#include "utils.h"
 #include "wireless.h"
 
 #include <HTTPUpdate.h>
+#include <lwip/sockets.h>
+#include <math.h>
+#include <time.h>
 
 // External configuration
 extern const char *host;
 extern const char *firmware;
 
-// Timeouts for HTTP operations
+// Timeouts for HTTP operations, scaled from latency history in RTC memory within these bounds
+#ifndef HTTP_FIRST_BYTE_TIMEOUT_MIN_MS
+  #define HTTP_FIRST_BYTE_TIMEOUT_MIN_MS 3000
+#endif
+#ifndef HTTP_FIRST_BYTE_TIMEOUT_MAX_MS
+  #define HTTP_FIRST_BYTE_TIMEOUT_MAX_MS 10000
+#endif
+#ifndef HTTP_IDLE_TIMEOUT_MIN_MS
+  #define HTTP_IDLE_TIMEOUT_MIN_MS 1000
+#endif
+#ifndef HTTP_IDLE_TIMEOUT_MAX_MS
+  #define HTTP_IDLE_TIMEOUT_MAX_MS 5000
+#endif
+
+// Timeout = margin x average + slack, total read timeout is a multiple of the idle one but never below
+// TOTAL_TIMEOUT_MS: a slow but steady link may need that long for a large read or a resume skip
+static constexpr uint32_t TIMEOUT_LATENCY_MARGIN = 4;
+static constexpr uint32_t TIMEOUT_LATENCY_SLACK_MS = 500;
+static constexpr uint32_t TOTAL_TO_IDLE_TIMEOUT_RATIO = 6;
 static constexpr uint32_t TOTAL_TIMEOUT_MS = 30000;
-static constexpr uint32_t IDLE_TIMEOUT_MS = 5000;
+
+// Upper bound for a single select() so connection state is rechecked regularly
+static constexpr uint32_t SOCKET_WAIT_SLICE_MS = 250;
+
+// Download power mode: with DOWNLOAD_MODEM_SLEEP the radio uses max modem sleep while the body arrives,
+// and goes back to the default mode (min modem sleep) for the rest of the download once throughput falls
+// below the threshold
+#ifndef DOWNLOAD_MODEM_SLEEP_MIN_THROUGHPUT
+  #define DOWNLOAD_MODEM_SLEEP_MIN_THROUGHPUT 8192 // bytes/s
+#endif
+static constexpr uint32_t THROUGHPUT_WINDOW_MS = 500;
+
+// Waits for body data longer than this count as stalls in the download metrics
+#ifndef DOWNLOAD_STALL_THRESHOLD_MS
+  #define DOWNLOAD_STALL_THRESHOLD_MS 200
+#endif
+
+// Smallest body counted towards the throughput reported to the server
+static constexpr uint32_t DOWNLOAD_THROUGHPUT_MIN_BYTES = 4096;
+
+// Rough average supply currents for the energy estimate in the download log: default power mode
+// (min modem sleep, radio awake for every DTIM while data flows) and max modem sleep
+#ifndef WIFI_ACTIVE_CURRENT_MA
+  #define WIFI_ACTIVE_CURRENT_MA 110
+#endif
+#ifndef WIFI_MODEM_SLEEP_CURRENT_MA
+  #define WIFI_MODEM_SLEEP_CURRENT_MA 40
+#endif
+
+static uint32_t adaptiveTimeout(uint32_t average, uint32_t minMs, uint32_t maxMs)
+{
+  if (average == 0)
+    return maxMs; // No history yet
+
+  uint32_t timeout = average * TIMEOUT_LATENCY_MARGIN + TIMEOUT_LATENCY_SLACK_MS;
+  return (timeout < minMs) ? minMs : (timeout > maxMs) ? maxMs : timeout;
+}
+
+constexpr size_t HttpClient::RX_BUFFER_SIZE;
+
+///////////////////////////////////////////////
+// DNS cache (survives deep sleep)
+///////////////////////////////////////////////
+
+// How long a resolved address is used without asking DNS again
+#ifndef DNS_CACHE_TTL_SECONDS
+  #define DNS_CACHE_TTL_SECONDS 3600
+#endif
+
+static constexpr uint8_t DNS_CACHE_ADDRESSES = 2;
+
+// Addresses in preference order, the first one connected last time.
+// The resolve time comes from the system clock, which keeps running through deep sleep.
+struct DnsCache
+{
+  uint32_t hostHash;
+  time_t resolvedAt;
+  uint32_t addresses[DNS_CACHE_ADDRESSES];
+
+  bool isValid(uint32_t hash, time_t now) const
+  {
+    return hostHash == hash && addresses[0] != 0 && now >= resolvedAt && now - resolvedAt < DNS_CACHE_TTL_SECONDS;
+  }
+};
+
+RTC_DATA_ATTR static DnsCache rtc_dnsCache = {};
+
+// FNV-1a, only used to notice a different host in the cache
+static uint32_t hashHost(const char *name)
+{
+  uint32_t hash = 2166136261u;
+  while (*name)
+  {
+    hash ^= (uint8_t)*name++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Move address to the front, keeping the previous ones as alternates
+static void rememberAddress(uint32_t address, uint32_t hash, time_t now)
+{
+  if (rtc_dnsCache.hostHash != hash)
+    memset(rtc_dnsCache.addresses, 0, sizeof(rtc_dnsCache.addresses));
+
+  uint8_t existing = DNS_CACHE_ADDRESSES - 1;
+  for (uint8_t i = 0; i < DNS_CACHE_ADDRESSES; i++)
+  {
+    if (rtc_dnsCache.addresses[i] == address)
+    {
+      existing = i;
+      break;
+    }
+  }
+
+  for (uint8_t i = existing; i > 0; i--)
+    rtc_dnsCache.addresses[i] = rtc_dnsCache.addresses[i - 1];
+  rtc_dnsCache.addresses[0] = address;
+  rtc_dnsCache.hostHash = hash;
+  rtc_dnsCache.resolvedAt = now;
+}
 
 HttpClient::HttpClient()
     : m_sleepDuration(StateManager::DEFAULT_SLEEP_SECONDS),
@@ -24,9 +150,48 @@ HttpClient::HttpClient()
       m_hasRotation(false),
       m_partialRefresh(false),
       m_otaRequired(false),
-      m_otaUrl(""),
+      m_otaUrl{},
+      m_contentHash{},
+      m_contentLength(-1),
       m_imageDataReady(false),
-      m_jsonPayload("")
+      m_rxPos(0),
+      m_rxLen(0),
+      m_chunked(false),
+      m_chunkRemaining(0),
+      m_bodyComplete(false),
+      m_handshakeRecorded(false),
+      m_lastHandshakeMs(0),
+      m_telemetry{},
+      m_fullTelemetry(true),
+      m_telemetryRecorded(false),
+      m_telemetryCollected(false),
+      m_bodyOffset(0),
+      m_bodyStart(0),
+      m_rangeStart(0),
+      m_partialContent(false),
+      m_requestFirstRow(0),
+      m_requestRowCount(0),
+      m_rowRangeFirst(0),
+      m_rowRangeCount(0),
+      m_keepAlive(false),
+      m_serverClose(true),
+      m_firstByteTimeoutMs(HTTP_FIRST_BYTE_TIMEOUT_MAX_MS),
+      m_idleTimeoutMs(HTTP_IDLE_TIMEOUT_MAX_MS),
+      m_totalTimeoutMs(TOTAL_TIMEOUT_MS),
+      m_maxReceiveGapMs(0),
+      m_lastFirstByteMs(0),
+      m_bodyPhaseActive(false),
+      m_powerSaveActive(false),
+      m_powerPhaseStart(0),
+      m_throughputWindowStart(0),
+      m_throughputWindowBytes(0),
+      m_phaseConnectMs(0),
+      m_phaseFirstByteMs(0),
+      m_powerSaveMs(0),
+      m_defaultModeMs(0),
+      m_phaseBodyBytes(0),
+      m_metrics{},
+      m_metricsIncluded(false)
 {
 #ifdef USE_CLIENT_HTTPS
   // Configure secure connection - only once in constructor
@@ -35,11 +200,133 @@ HttpClient::HttpClient()
 #endif
 }
 
+///////////////////////////////////////////////
+// Request body
+///////////////////////////////////////////////
+
+// Print adapter collecting small writes into a fixed buffer, sent to the client in larger segments
+class BufferedClientWriter : public Print
+{
+public:
+  BufferedClientWriter(Client &client, uint8_t *buffer, size_t size)
+      : m_client(client), m_buffer(buffer), m_size(size), m_used(0), m_written(0), m_writes(0)
+  {
+  }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+
+  size_t write(const uint8_t *data, size_t length) override
+  {
+    size_t remaining = length;
+    while (remaining > 0)
+    {
+      if (m_used == m_size && !sendBuffered())
+        break;
+
+      size_t toCopy = (remaining < m_size - m_used) ? remaining : m_size - m_used;
+      memcpy(m_buffer + m_used, data, toCopy);
+      m_used += toCopy;
+      data += toCopy;
+      remaining -= toCopy;
+    }
+    return length - remaining;
+  }
+
+  bool sendBuffered()
+  {
+    if (m_used == 0)
+      return true;
+
+    size_t sent = m_client.write(m_buffer, m_used);
+    m_written += sent;
+    m_writes++;
+    bool ok = sent == m_used;
+    m_used = 0;
+    return ok;
+  }
+
+  size_t written() const { return m_written; }
+  size_t buffered() const { return m_used; }
+  size_t writes() const { return m_writes; }
+
+private:
+  Client &m_client;
+  uint8_t *m_buffer;
+  size_t m_size;
+  size_t m_used;
+  size_t m_written;
+  size_t m_writes;
+};
+
+// Read sensors and decide compact/full payload once per wake, kept for rebuilding the document later
+void HttpClient::collectTelemetry()
+{
+  if (m_telemetryCollected)
+    return;
+
+  // Values watched for the compact/full payload decision
+  m_telemetry = {Wireless::getStrength(), Board::getBatteryVoltage(), NAN};
+#ifdef SENSOR
+  m_sensorData = Sensor::getInstance().getSensorData();
+  if (m_sensorData.isValid)
+    m_telemetry.temperature = m_sensorData.temperature;
+#endif
+
+#ifdef TELEMETRY_COMPACT_DISABLED
+  m_fullTelemetry = true;
+#else
+  m_fullTelemetry = StateManager::isFullTelemetryDue(m_telemetry);
+#endif
+
+  m_telemetryCollected = true;
+}
+
+// Metrics of the previous download, sent until the server has received them once
+void HttpClient::addDownloadMetrics(JsonObject network)
+{
+  const StateManager::DownloadMetrics &metrics = StateManager::getDownloadMetrics();
+  m_metricsIncluded = metrics.requests > 0 && !metrics.reported;
+  if (!m_metricsIncluded)
+    return;
+
+  JsonObject download = network["download"].to<JsonObject>();
+  download["connections"] = metrics.connections;
+  download["requests"] = metrics.requests;
+  download["dnsMs"] = metrics.dnsMs;
+  download["connectMs"] = metrics.connectMs; // TCP connect + TLS handshake
+  download["firstByteMs"] = metrics.firstByteMs;
+  download["bodyMs"] = metrics.bodyMs;
+  download["bytes"] = metrics.bytes;
+  if (metrics.bodyMs > 0)
+    download["bytesPerSecond"] = (uint32_t)((uint64_t)metrics.bytes * 1000 / metrics.bodyMs);
+  download["stallThresholdMs"] = DOWNLOAD_STALL_THRESHOLD_MS;
+  download["stalls"] = metrics.stallCount;
+  download["stallMs"] = metrics.stallMs;
+  // Socket read sizes: <128, <512, <1024, >=1024 bytes
+  JsonArray readSizes = download["readSizes"].to<JsonArray>();
+  for (uint16_t count : metrics.readSizes)
+    readSizes.add(count);
+}
+
 void HttpClient::buildJsonPayload()
 {
-  // Only build once - if already built, skip
-  if (m_jsonPayload.length() > 0)
+  // Document is freed after each request and rebuilt from the collected values when needed again
+  if (!m_jsonDoc.isNull())
+    return;
+
+  collectTelemetry();
+
+  // Compact payload - only what the server needs to answer the timestamp check plus critical values
+  if (!m_fullTelemetry)
+  {
+    m_jsonDoc["apiVersion"] = firmware;
+    m_jsonDoc["compact"] = true;
+    m_jsonDoc["timestamp"] = StateManager::getTimestamp();
+    m_jsonDoc["system"]["vccVoltage"] = m_telemetry.voltage;
+    m_jsonDoc["network"]["rssi"] = m_telemetry.rssi;
+    addDownloadMetrics(m_jsonDoc["network"].to<JsonObject>());
     return;
+  }
 
   // API and firmware info
   m_jsonDoc["fwVersion"] = firmware;
@@ -51,18 +338,22 @@ void HttpClient::buildJsonPayload()
   JsonObject system = m_jsonDoc["system"].to<JsonObject>();
   system["cpuTemp"] = Board::getCPUTemperature();
   system["resetReason"] = Board::getResetReasonString();
-  system["vccVoltage"] = Board::getBatteryVoltage();
+  system["vccVoltage"] = m_telemetry.voltage;
 
   // Network info
   JsonObject network = m_jsonDoc["network"].to<JsonObject>();
   network["ssid"] = WiFi.SSID();
-  network["rssi"] = Wireless::getStrength();
+  network["rssi"] = m_telemetry.rssi;
   network["mac"] = Wireless::getMacAddress();
   network["apRetries"] = StateManager::getFailureCount();
   network["ipAddress"] = Wireless::getIPAddress();
   // Add last download duration if available from previous run (in milliseconds)
   if (StateManager::getLastDownloadDuration() > 0)
     network["lastDownloadDuration"] = StateManager::getLastDownloadDuration();
+  // Add last TLS handshake duration (without DNS and TCP connect) from previous run (in milliseconds)
+  if (StateManager::getLastHandshakeDuration() > 0)
+    network["lastHandshakeDuration"] = StateManager::getLastHandshakeDuration();
+  addDownloadMetrics(network);
 
   // Display info
   JsonObject display = m_jsonDoc["display"].to<JsonObject>();
@@ -74,31 +365,66 @@ void HttpClient::buildJsonPayload()
   if (StateManager::getLastRefreshDuration() > 0)
     display["lastRefreshDuration"] = StateManager::getLastRefreshDuration();
 
+  // Capabilities, so the server can pick the cheapest format and encoding for this device
+  JsonObject capabilities = m_jsonDoc["capabilities"].to<JsonObject>();
+  ImageHandler::getSupportedFormats(capabilities["formats"].to<JsonArray>());
+#ifdef HTTP_COMPRESSION_ENABLED
+  JsonArray encodings = capabilities["encodings"].to<JsonArray>();
+  encodings.add("deflate");
+  #if HTTP_INFLATE_WINDOW_BITS == 15
+  encodings.add("gzip"); // No window size in the stream, only accepted with the full window
+  #endif
+  capabilities["inflateWindowBits"] = HTTP_INFLATE_WINDOW_BITS;
+#endif
+  capabilities["directStreaming"] = ImageHandler::isDirectStreamingAvailable();
+  // Row buffer height direct streaming got last time (limited by free heap)
+  if (StateManager::getStreamingRows() > 0)
+    capabilities["bandRows"] = StateManager::getStreamingRows();
+  capabilities["nativeFormat"] = PixelPacker::getFormatName(PixelPacker::getDisplayFormat());
+  capabilities["bitsPerPixel"] = PixelPacker::getBitsPerPixel(PixelPacker::getDisplayFormat());
+  capabilities["freeHeap"] = Utils::getFreeHeap();
+  capabilities["largestFreeBlock"] = Utils::getLargestFreeBlock();
+  capabilities["psram"] = ESP.getPsramSize() > 0;
+  // Body download speed from previous downloads (bytes/s)
+  if (StateManager::getDownloadThroughput() > 0)
+    capabilities["throughput"] = StateManager::getDownloadThroughput();
+
 #ifdef SENSOR
   // Add sensor data if available
-  SensorData sensorData = Sensor::getInstance().getSensorData();
-  if (sensorData.isValid)
+  if (m_sensorData.isValid)
   {
     JsonArray sensors = m_jsonDoc["sensors"].to<JsonArray>();
-    sensorData.toJson(sensors);
+    m_sensorData.toJson(sensors);
   }
 #endif
-
-  serializeJson(m_jsonDoc, m_jsonPayload);
 }
 
-bool HttpClient::sendRequest(bool timestampCheck)
+bool HttpClient::openConnection(bool timestampCheck)
 {
-  // Build JSON payload (only built once, cached for subsequent requests)
-  buildJsonPayload();
-
   Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Connecting to: {}\n", host);
 
   // Try to connect with retries
   for (uint8_t attempt = 0; attempt < 3; attempt++)
   {
-    if (m_client.connect(host, CONNECTION_PORT))
-      break;
+    uint32_t connectStart = millis();
+    uint32_t dnsBefore = m_metrics.dnsMs;
+    if (connectToHost())
+    {
+      // Covers TCP and the TLS handshake (plus DNS when not cached)
+      uint32_t connectDuration = millis() - connectStart;
+      Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Connected in {} ms\n", connectDuration);
+      m_phaseConnectMs += connectDuration;
+      m_metrics.connectMs += connectDuration - (m_metrics.dnsMs - dnsBefore);
+      m_metrics.connections++;
+
+      // TLS phase alone, reported with the next wake's telemetry
+      if (!m_handshakeRecorded && m_lastHandshakeMs > 0)
+      {
+        StateManager::setLastHandshakeDuration(m_lastHandshakeMs);
+        m_handshakeRecorded = true;
+      }
+      return true;
+    }
 
     Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Connection failed, retrying... {}/3\n", attempt + 1);
     if (attempt == 2)
@@ -112,256 +438,1228 @@ bool HttpClient::sendRequest(bool timestampCheck)
       delay(200);
   }
 
-  // Send HTTP/HTTPS POST request with JSON body
-  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Sending POST to: {}{}/index.php\n", CONNECTION_URL_PREFIX,
-                                                         host);
+  return false;
+}
 
-  // Pretty print JSON payload for device info
-  String prettyJson;
-  serializeJsonPretty(m_jsonDoc, prettyJson);
-  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("JSON Payload:\n{}\n", prettyJson);
-
-  // Build URL with timestampCheck query parameter
-  String url = "/index.php?timestampCheck=";
-  url += timestampCheck ? "1" : "0";
-
-  // Send HTTP request using multiple print() calls to avoid allocating one large heap String
-  m_client.print("POST ");
-  m_client.print(url);
-  m_client.print(" HTTP/1.1\r\nHost: ");
-  m_client.print(host);
-  m_client.print("\r\nX-API-Key: ");
-  m_client.print(Utils::getStoredAPIKey());
-  m_client.print("\r\nContent-Type: application/json\r\nContent-Length: ");
-  m_client.print(m_jsonPayload.length());
-  m_client.print("\r\nConnection: close\r\n\r\n");
-  m_client.print(m_jsonPayload);
+// Previous response fully consumed and the server agreed to keep the socket open
+bool HttpClient::reuseConnection()
+{
+  if (m_serverClose || !m_client.connected())
+    return false;
 
-  Logger::log<Logger::Topic::HTTP>("Request sent\n");
+  // A body without Content-Length or chunked framing only ends when the server closes
+  if (!m_chunked && m_contentLength < 0)
+    return false;
 
-  // Wait for response with timeout
-  uint32_t timeout = millis();
-  while (m_client.available() == 0)
+  // A few bytes left behind by the decoder are cheaper to drain than a new handshake.
+  // Drained below the Content-Encoding layer, there is nothing left to inflate.
+  uint32_t drained = 0;
+  while (!isBodyComplete() && drained < KEEP_ALIVE_MAX_DRAIN && ensureBodyData())
   {
-    if (millis() - timeout > 10000)
-    {
-      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>(">>> Client Timeout!\n");
-      m_client.stop();
-      if (timestampCheck)
-        m_sleepDuration = StateManager::DEFAULT_SLEEP_SECONDS;
-      return false;
-    }
+    size_t buffered = bodyBuffered();
+    consumeBody(buffered);
+    drained += buffered;
   }
 
-  return true;
+  if (drained > 0)
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Drained {} bytes of previous response\n", drained);
+
+  // Anything past the body would be a response nobody asked for
+  return isBodyComplete() && rxBuffered() == 0;
 }
 
-bool HttpClient::parseHeaders(bool checkTimestampOnly, uint64_t storedTimestamp)
+bool HttpClient::sendRequest(bool timestampCheck)
 {
-  bool connectionOk = false;
-  bool foundTimestamp = false;
-  m_hasRotation = false;
-  m_partialRefresh = false;
-  m_otaRequired = false;
-  m_otaUrl = "";
-
-  while (m_client.connected() || m_client.available())
-  {
-    String line = m_client.readStringUntil('\n');
+  // Build JSON payload before connecting, sensor reads can take a while
+  buildJsonPayload();
 
-    // Parse headers only when checking timestamp
-    if (checkTimestampOnly)
-    {
-      // Parse X-OTA-Update header for firmware update
-      if (line.startsWith("X-OTA-Update"))
-      {
-        m_otaUrl = line.substring(14); // Skip "X-OTA-Update: "
-        m_otaUrl.trim();               // Remove whitespace and \r
-        m_otaRequired = true;
-        Logger::log<Logger::Topic::HEADER>("OTA Update requested: {}\n", m_otaUrl);
-      }
+  // Previous response is done with, its slowest stretch feeds the next idle timeouts
+  recordReceiveGap();
+  updateTimeouts();
 
-      // Parse Timestamp header
-      if (line.startsWith("Timestamp"))
-      {
-        foundTimestamp = true;
-        // Skipping also colon and space - also in following code for sleep, rotate, ...
-        m_serverTimestamp = line.substring(11).toInt();
-        Logger::log<Logger::Topic::HEADER>("Timestamp now: {}\n", m_serverTimestamp);
-      }
+  // Keep-alive: next request goes out on the same socket once the previous body is consumed
+  bool reused = m_keepAlive && reuseConnection();
+  if (!reused)
+    m_client.stop();
 
-      // Is there another header (after the Sleep one) with sleep in Seconds?
-      if (line.startsWith("PreciseSleep"))
-      {
-        m_sleepDuration = line.substring(14).toInt();
-        Logger::log<Logger::Topic::HEADER>("Precise Sleep in seconds: {}\n", m_sleepDuration);
-      }
+  // Drop anything left over from a previous response
+  resetRxBuffer();
+  resetBodyState();
 
-      // Do we want to rotate display? (IE. upside down)
-      if (line.startsWith("Rotate"))
-      {
-        m_displayRotation = line.substring(8).toInt();
-        m_hasRotation = true;
-        Logger::log<Logger::Topic::HEADER>("Rotation: {}\n", m_displayRotation);
-      }
+  if (reused)
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Reusing kept-alive connection\n");
+  else if (!openConnection(timestampCheck))
+    return false;
 
-      // Partial refresh request from server (only if this line exists)
-      if (line.startsWith("PartialRefresh"))
-      {
-        m_partialRefresh = true;
-        Logger::log<Logger::Topic::HEADER>("Partial refresh requested\n");
-      }
+  writeRequest(timestampCheck);
 
-      // ShowNoWifiError setting (1 = show error on display, 0 = keep existing content)
-      if (line.startsWith("ShowNoWifiError"))
+  if (!waitForResponse())
+  {
+    // Server may have dropped the idle socket just as the request went out, retry once on a new connection
+    if (reused)
+    {
+      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Kept-alive connection was closed, reconnecting\n");
+      m_client.stop();
+      resetRxBuffer();
+      if (openConnection(timestampCheck))
       {
-        uint8_t showNoWifiError = line.substring(17).toInt(); // Skip "ShowNoWifiError: "
-        StateManager::setShowNoWifiError(showNoWifiError);
-        Logger::log<Logger::Topic::HEADER>("ShowNoWifiError: {}\n", showNoWifiError);
+        writeRequest(timestampCheck);
+        reused = waitForResponse();
       }
     }
 
-    // Check for successful HTTP response (always check)
-    if (!connectionOk)
+    if (!reused)
     {
-      // Support both HTTP/1.0 and HTTP/1.1
-      connectionOk = line.startsWith("HTTP/1.1 200 OK") || line.startsWith("HTTP/1.0 200 OK");
-      Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("{}\n", line);
+      m_client.stop();
+      if (timestampCheck)
+        m_sleepDuration = StateManager::DEFAULT_SLEEP_SECONDS;
+      return false;
     }
+  }
 
-    // End of headers
-    if (line == "\r")
-    {
-      Logger::log<Logger::Topic::HTTP>("Headers received\n");
-      break;
-    }
+  // Server got the payload, count it towards the next compact/full decision (once per wake)
+  if (!m_telemetryRecorded)
+  {
+    StateManager::recordTelemetrySent(m_fullTelemetry, m_telemetry);
+    if (m_metricsIncluded)
+      StateManager::markDownloadMetricsReported();
+    m_telemetryRecorded = true;
   }
 
-  // Is there a problem? Fallback to default deep sleep time to try again soon
-  if (!connectionOk)
+  return true;
+}
+
+void HttpClient::writeRequest(bool timestampCheck)
+{
+  // Build JSON payload (freed again once the request is sent)
+  buildJsonPayload();
+
+  // Send HTTP/HTTPS POST request with JSON body
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Sending POST to: {}{}/index.php\n", CONNECTION_URL_PREFIX,
+                                                         host);
+
+  // Body is serialized straight to the socket, only its length is needed upfront
+  size_t payloadLength = measureJson(m_jsonDoc);
+
+  // Pretty print JSON payload for device info, the String only exists in debug builds
+  if (Logger::isEnabled<Logger::Level::DEBUG>())
   {
-    m_sleepDuration = StateManager::DEFAULT_SLEEP_SECONDS;
-    return false;
+    String prettyJson;
+    serializeJsonPretty(m_jsonDoc, prettyJson);
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("JSON Payload ({} bytes):\n{}\n", payloadLength,
+                                                           prettyJson);
   }
 
-  // For debug purposes - print out the whole response
-  /*
-  String data = "";
-  while (m_client.connected() || m_client.available()) {
-    if (m_client.available()) {
-      data += m_client.read();  // Read one byte
-    }
+  // Request line, headers and JSON body are assembled in the idle receive buffer and go out in as few
+  // writes as possible (one TLS record and TCP segment when it all fits), the rest is streamed after it
+  BufferedClientWriter writer(m_client, m_rxBuffer, RX_BUFFER_SIZE);
+
+  // URL with timestampCheck query parameter
+  writer.print("POST /index.php?timestampCheck=");
+  writer.print(timestampCheck ? "1" : "0");
+
+  // Only these rows of the image are needed (paged mode)
+  if (m_requestRowCount > 0)
+  {
+    writer.print("&rowStart=");
+    writer.print(m_requestFirstRow);
+    writer.print("&rowCount=");
+    writer.print(m_requestRowCount);
   }
-  m_client.stop();
-  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Byte by byte:{}\n", data);
-  /* */
 
-  // If checking timestamp, see if content changed
-  if (checkTimestampOnly)
+  writer.print(" HTTP/1.1\r\nHost: ");
+  writer.print(host);
+  writer.print("\r\nX-API-Key: ");
+  writer.print(Utils::getStoredAPIKey());
+  writer.print("\r\nContent-Type: application/json\r\nContent-Length: ");
+  writer.print(payloadLength);
+  if (m_rangeStart > 0)
   {
-    // Always save sleep duration from server, even if no update is needed
-    StateManager::setSleepDuration(m_sleepDuration);
+    // Continue an interrupted download, byte offsets only line up with an unencoded body
+    writer.print("\r\nRange: bytes=");
+    writer.print(m_rangeStart);
+    writer.print("-\r\nAccept-Encoding: identity");
+  }
+#ifdef HTTP_COMPRESSION_ENABLED
+  else
+  {
+    // Only zlib-wrapped deflate, its header states the window and a larger one is refused. Stock gzip modules
+    // compress with 32 KB and ignore X-Inflate-Window-Bits, so the server has to honour that header itself.
+    writer.print("\r\nAccept-Encoding: deflate\r\nX-Inflate-Window-Bits: ");
+    writer.print(HTTP_INFLATE_WINDOW_BITS);
+  }
+#endif
+  writer.print(m_keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+  size_t headerLength = writer.written() + writer.buffered();
 
-    if (foundTimestamp && (m_serverTimestamp == storedTimestamp))
-    {
-      Logger::log<Logger::Topic::HTTP>("No screen reload, still at current timestamp: {}\n", storedTimestamp);
+  serializeJson(m_jsonDoc, writer);
+  writer.sendBuffered();
+  if (writer.written() != headerLength + payloadLength)
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Request write incomplete: {}/{} bytes\n",
+                                                             writer.written(), headerLength + payloadLength);
 
-      StateManager::setLastRefreshDuration(0);
+  // Release document memory before the response (image) is streamed
+  m_jsonDoc.clear();
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Request: {} bytes in {} writes\n", writer.written(),
+                                                         writer.writes());
+  Logger::log<Logger::Topic::HTTP>("Request sent\n");
+}
+
+bool HttpClient::waitForResponse()
+{
+  // Wait for response with timeout, blocked on the socket while the server renders
+  uint32_t start = millis();
+  while (m_client.available() == 0)
+  {
+    // Closed without a single byte, nothing more will come
+    if (!m_client.connected())
+    {
+      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Connection closed before response\n");
+      return false;
+    }
 
+    uint32_t waited = millis() - start;
+    if (waited > m_firstByteTimeoutMs)
+    {
+      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>(">>> Client Timeout after {} ms!\n", waited);
+      // At least this slow, whatever the response would have been (a resume is answered from what's rendered)
+      if (m_rangeStart == 0)
+        StateManager::recordFirstByteLatency(waited);
       return false;
     }
 
-    // Set timestamp to actual one
-    StateManager::setTimestamp(m_serverTimestamp);
+    waitForSocket(m_firstByteTimeoutMs - waited);
   }
 
+  uint32_t latency = millis() - start;
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("First response byte after {} ms\n", latency);
+  m_phaseFirstByteMs += latency;
+  m_metrics.firstByteMs += latency;
+  m_metrics.requests++;
+  m_lastFirstByteMs = latency; // Goes into the history once the headers show an image body (recordImageLatency)
+
   return true;
 }
 
-bool HttpClient::checkForUpdate(bool timestampCheck, bool keepConnectionOpen)
+// First-byte latency history only follows responses that carry a freshly rendered image. Unchanged timestamp
+// checks and Range resumes are answered without rendering, their fast replies would shrink the timeout
+// below the render time of the next image request.
+void HttpClient::recordImageLatency()
 {
-  m_imageDataReady = false;
+  if (m_rangeStart == 0 && m_lastFirstByteMs > 0)
+    StateManager::recordFirstByteLatency(m_lastFirstByteMs);
+  m_lastFirstByteMs = 0;
+}
 
-  if (!sendRequest(timestampCheck))
-    return false;
+// Block until the socket is readable, closed, or timeoutMs passes.
+// The task sleeps in select() so the idle task can run (and light sleep when power management allows it).
+void HttpClient::waitForSocket(uint32_t timeoutMs)
+{
+  if (timeoutMs > SOCKET_WAIT_SLICE_MS)
+    timeoutMs = SOCKET_WAIT_SLICE_MS;
 
-  if (!parseHeaders(true, StateManager::getTimestamp()))
+  int fd = m_client.fd();
+  if (fd < 0)
   {
-    m_client.stop();
-    return false;
+    // No socket handle exposed by this client, fall back to polling
+    delay(1);
+    return;
   }
 
-  // Update sleep duration from headers
-  StateManager::setSleepDuration(m_sleepDuration);
+  fd_set readSet;
+  FD_ZERO(&readSet);
+  FD_SET(fd, &readSet);
+  struct timeval tv;
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
 
-  // If keepConnectionOpen is requested, don't close - image data is ready to read
-  if (keepConnectionOpen)
-  {
-    m_imageDataReady = true;
-    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Connection kept open, image data ready\n");
-    return true; // Update available, connection open
-  }
+  int ready = select(fd + 1, &readSet, nullptr, nullptr, &tv);
 
-  m_client.stop();
-  return true; // Update available
+  // Readable socket with nothing decodable yet (partial TLS record), don't spin on it
+  if (ready > 0 && m_client.available() == 0)
+    delay(1);
 }
 
-bool HttpClient::startImageDownload()
+void HttpClient::updateTimeouts()
 {
-  if (!sendRequest(false))
-    return false;
-
-  if (!parseHeaders(false, 0))
-  {
-    m_client.stop();
-    return false;
-  }
-
-  // Client stays open for image data
-  return true;
+  m_firstByteTimeoutMs = adaptiveTimeout(StateManager::getFirstByteLatency(), HTTP_FIRST_BYTE_TIMEOUT_MIN_MS,
+                                         HTTP_FIRST_BYTE_TIMEOUT_MAX_MS);
+  m_idleTimeoutMs =
+    adaptiveTimeout(StateManager::getReceiveGap(), HTTP_IDLE_TIMEOUT_MIN_MS, HTTP_IDLE_TIMEOUT_MAX_MS);
+  uint32_t totalTimeoutMs = m_idleTimeoutMs * TOTAL_TO_IDLE_TIMEOUT_RATIO;
+  m_totalTimeoutMs = (totalTimeoutMs > TOTAL_TIMEOUT_MS) ? totalTimeoutMs : TOTAL_TIMEOUT_MS;
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Timeouts: first byte {} ms, idle {} ms, total {} ms\n",
+                                                         m_firstByteTimeoutMs, m_idleTimeoutMs, m_totalTimeoutMs);
 }
 
-bool HttpClient::isConnected() { return m_client.connected() || m_client.available(); }
+void HttpClient::recordReceiveGap()
+{
+  if (m_maxReceiveGapMs == 0)
+    return;
 
-int HttpClient::available() { return m_client.available(); }
+  StateManager::recordReceiveGap(m_maxReceiveGapMs);
+  m_maxReceiveGapMs = 0;
+}
 
-void HttpClient::stop()
+bool HttpClient::connectAddress(uint32_t address)
 {
-  m_client.stop();
-  m_imageDataReady = false;
+#ifdef USE_CLIENT_HTTP
+  return m_client.connect(IPAddress(address), CONNECTION_PORT);
+#else
+  // Host name is still needed for SNI, and picks the cached TLS session
+  TlsSession::arm(hashHost(host));
+  bool connected = m_client.connect(IPAddress(address), CONNECTION_PORT, host, nullptr, nullptr, nullptr);
+  m_lastHandshakeMs = TlsSession::finish(connected);
+  return connected;
+#endif
 }
 
-uint32_t HttpClient::readBytes(uint8_t *buf, int32_t bytes)
+// Addresses for host in preference order: the cached ones while the cache is valid (and useCache is set),
+// otherwise a fresh lookup that is stored in the cache. Returns how many were filled in, 0 if DNS failed.
+uint8_t HttpClient::resolveHost(uint32_t *addresses, bool useCache, bool &fromCache)
 {
-  int32_t remaining = bytes;
-  uint32_t startTime = millis();
-  uint32_t lastDataTime = startTime;
+  uint32_t hash = hashHost(host);
+  time_t now = time(nullptr);
 
-  while ((m_client.connected() || m_client.available()) && remaining > 0)
+  fromCache = useCache && rtc_dnsCache.isValid(hash, now);
+  if (fromCache)
   {
-    if (m_client.available())
+    uint8_t count = 0;
+    while (count < DNS_CACHE_ADDRESSES && rtc_dnsCache.addresses[count] != 0)
     {
-      int16_t val = m_client.read();
-      if (buf)
-        *buf++ = (uint8_t)val;
-      remaining--;
-      lastDataTime = millis(); // Reset idle timeout on data received
+      addresses[count] = rtc_dnsCache.addresses[count];
+      count++;
     }
-    else
+    return count;
+  }
+
+  uint32_t resolveStart = millis();
+  IPAddress resolved;
+  if (!WiFi.hostByName(host, resolved) || (uint32_t)resolved == 0)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("DNS lookup for {} failed\n", host);
+    return 0;
+  }
+  uint32_t resolveDuration = millis() - resolveStart;
+  m_metrics.dnsMs += resolveDuration;
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Resolved {} to {} in {} ms\n", host, resolved.toString(),
+                                                         resolveDuration);
+
+  addresses[0] = resolved;
+  rememberAddress(addresses[0], hash, now);
+  return 1;
+}
+
+// Connect using cached addresses first, fall back to a fresh DNS lookup
+bool HttpClient::connectToHost()
+{
+  uint32_t addresses[DNS_CACHE_ADDRESSES];
+
+  for (bool useCache = true;; useCache = false)
+  {
+    bool fromCache;
+    uint8_t count = resolveHost(addresses, useCache, fromCache);
+
+    for (uint8_t i = 0; i < count; i++)
     {
-      delay(1);
+      if (fromCache)
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Using cached address {}\n",
+                                                               IPAddress(addresses[i]).toString());
+      if (connectAddress(addresses[i]))
+      {
+        // Keeps the resolve time, a cached address does not extend its TTL
+        rememberAddress(addresses[i], hashHost(host), rtc_dnsCache.resolvedAt);
+        return true;
+      }
     }
 
-    uint32_t now = millis();
-    // Check idle timeout (no data for too long)
-    if (now - lastDataTime > IDLE_TIMEOUT_MS)
+    if (!fromCache)
+      return false;
+
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Cached addresses failed, resolving again\n");
+  }
+}
+
+///////////////////////////////////////////////
+// Response header parsing
+///////////////////////////////////////////////
+
+// Response headers known to the firmware
+enum class ResponseHeader : uint8_t
+{
+  Timestamp,
+  PreciseSleep,
+  Rotate,
+  PartialRefresh,
+  ShowNoWifiError,
+  OtaUpdate,
+  ContentLength,
+  TransferEncoding,
+  ContentHash,
+  ContentRange,
+  RowRange,
+  Connection,
+  ContentEncoding
+};
+
+struct ResponseHeaderEntry
+{
+  const char *name;
+  uint8_t nameLength;
+  ResponseHeader id;
+  bool timestampCheckOnly; // Server settings are only taken from the timestamp check response
+};
+
+#define RESPONSE_HEADER(name, id, timestampCheckOnly) {name, sizeof(name) - 1, id, timestampCheckOnly}
+
+static const ResponseHeaderEntry KNOWN_HEADERS[] = {
+  RESPONSE_HEADER("Timestamp", ResponseHeader::Timestamp, true),
+  RESPONSE_HEADER("PreciseSleep", ResponseHeader::PreciseSleep, true),
+  RESPONSE_HEADER("Rotate", ResponseHeader::Rotate, true),
+  RESPONSE_HEADER("PartialRefresh", ResponseHeader::PartialRefresh, true),
+  RESPONSE_HEADER("ShowNoWifiError", ResponseHeader::ShowNoWifiError, true),
+  RESPONSE_HEADER("X-OTA-Update", ResponseHeader::OtaUpdate, true),
+  RESPONSE_HEADER("Content-Length", ResponseHeader::ContentLength, false),
+  RESPONSE_HEADER("Transfer-Encoding", ResponseHeader::TransferEncoding, false),
+  RESPONSE_HEADER("X-Content-Hash", ResponseHeader::ContentHash, true),
+  RESPONSE_HEADER("Content-Range", ResponseHeader::ContentRange, false),
+  RESPONSE_HEADER("X-Row-Range", ResponseHeader::RowRange, false),
+  RESPONSE_HEADER("Connection", ResponseHeader::Connection, false),
+  RESPONSE_HEADER("Content-Encoding", ResponseHeader::ContentEncoding, false),
+};
+
+#undef RESPONSE_HEADER
+
+// Look up header name (case-insensitive) in the table, on match points value to the trimmed value in place
+static const ResponseHeaderEntry *matchHeader(char *line, char **value)
+{
+  char *colon = strchr(line, ':');
+  if (!colon)
+    return nullptr;
+
+  size_t nameLength = colon - line;
+  while (nameLength > 0 && (line[nameLength - 1] == ' ' || line[nameLength - 1] == '\t'))
+    nameLength--;
+
+  for (const ResponseHeaderEntry &entry : KNOWN_HEADERS)
+  {
+    if (entry.nameLength != nameLength || strncasecmp(line, entry.name, nameLength) != 0)
+      continue;
+
+    char *start = colon + 1;
+    while (*start == ' ' || *start == '\t')
+      start++;
+
+    char *end = start + strlen(start);
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t'))
+      *--end = '\0';
+
+    *value = start;
+    return &entry;
+  }
+
+  return nullptr;
+}
+
+// Status code from "HTTP/1.0 xxx" and "HTTP/1.1 xxx" status lines, 0 for anything else.
+// http10 is set for HTTP/1.0 responses.
+static uint16_t parseStatusCode(const char *line, int32_t length, bool *http10)
+{
+  static const char PREFIX[] = "HTTP/1.";
+  const int32_t prefixLength = sizeof(PREFIX) - 1;
+  *http10 = false;
+
+  // Version digit, space and a 3-digit code
+  if (length < prefixLength + 5 || strncmp(line, PREFIX, prefixLength) != 0)
+    return 0;
+  if ((line[prefixLength] != '0' && line[prefixLength] != '1') || line[prefixLength + 1] != ' ')
+    return 0;
+
+  *http10 = line[prefixLength] == '0';
+  return strtoul(line + prefixLength + 2, nullptr, 10);
+}
+
+// Chunked must be the last transfer coding applied, e.g. "gzip, chunked"
+static bool isChunkedEncoding(const char *value)
+{
+  static const char CHUNKED[] = "chunked";
+  size_t length = strlen(value);
+  if (length < sizeof(CHUNKED) - 1)
+    return false;
+  return strcasecmp(value + length - (sizeof(CHUNKED) - 1), CHUNKED) == 0;
+}
+
+// Content codings the inflate layer handles, false for anything else.
+// gzip does not state its window, it is only safe when ours is the full 32 KB.
+static bool parseContentEncoding(const char *value, InflateStream::Encoding *encoding)
+{
+  if ((strcasecmp(value, "gzip") == 0 || strcasecmp(value, "x-gzip") == 0) && HTTP_INFLATE_WINDOW_BITS == 15)
+    *encoding = InflateStream::Encoding::Gzip;
+  else if (strcasecmp(value, "deflate") == 0)
+    *encoding = InflateStream::Encoding::Deflate;
+  else
+    return false;
+  return true;
+}
+
+bool HttpClient::parseHeaders(bool checkTimestampOnly, uint64_t storedTimestamp)
+{
+  bool connectionOk = false;
+  bool foundTimestamp = false;
+  m_hasRotation = false;
+  m_partialRefresh = false;
+  m_otaRequired = false;
+  m_otaUrl[0] = '\0';
+  m_contentHash[0] = '\0';
+  m_contentLength = -1;
+  int32_t contentLength = -1;
+  m_serverClose = true;
+  m_partialContent = false;
+  m_rowRangeFirst = 0;
+  m_rowRangeCount = 0;
+  bool chunked = false;
+  int64_t contentRangeStart = -1;
+  bool encoded = false;
+  InflateStream::Encoding encoding = InflateStream::Encoding::Gzip;
+
+  // Fixed line buffer, headers are parsed in place without heap allocations
+  char line[HEADER_LINE_BUFFER_SIZE];
+
+  while (isConnected())
+  {
+    int32_t length = readUntil('\n', line, sizeof(line));
+    if (length < 0)
+      break; // Connection closed or timed out before end of headers
+
+    if (length > 0 && line[length - 1] == '\r')
+      line[--length] = '\0';
+
+    // End of headers
+    if (length == 0)
     {
-      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Idle timeout after {} ms without data\n",
-                                                               now - lastDataTime);
+      Logger::log<Logger::Topic::HTTP>("Headers received\n");
       break;
     }
+
+    // Check for successful HTTP response (always check)
+    if (!connectionOk)
+    {
+      // 206 is only valid as an answer to our own Range request
+      bool http10;
+      uint16_t statusCode = parseStatusCode(line, length, &http10);
+      m_serverClose = http10; // HTTP/1.0 closes unless it says otherwise
+      m_partialContent = statusCode == 206 && m_rangeStart > 0;
+      connectionOk = statusCode == 200 || m_partialContent;
+      Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("{}\n", line);
+      continue;
+    }
+
+    char *value = nullptr;
+    const ResponseHeaderEntry *header = matchHeader(line, &value);
+    if (!header || (header->timestampCheckOnly && !checkTimestampOnly))
+      continue;
+
+    switch (header->id)
+    {
+      case ResponseHeader::Timestamp:
+        foundTimestamp = true;
+        m_serverTimestamp = strtoull(value, nullptr, 10);
+        Logger::log<Logger::Topic::HEADER>("Timestamp now: {}\n", m_serverTimestamp);
+        break;
+
+      // Is there another header (after the Sleep one) with sleep in Seconds?
+      case ResponseHeader::PreciseSleep:
+        m_sleepDuration = strtoull(value, nullptr, 10);
+        Logger::log<Logger::Topic::HEADER>("Precise Sleep in seconds: {}\n", m_sleepDuration);
+        break;
+
+      // Do we want to rotate display? (IE. upside down)
+      case ResponseHeader::Rotate:
+        m_displayRotation = strtoul(value, nullptr, 10);
+        m_hasRotation = true;
+        Logger::log<Logger::Topic::HEADER>("Rotation: {}\n", m_displayRotation);
+        break;
+
+      // Partial refresh request from server (only if this line exists)
+      case ResponseHeader::PartialRefresh:
+        m_partialRefresh = true;
+        Logger::log<Logger::Topic::HEADER>("Partial refresh requested\n");
+        break;
+
+      // ShowNoWifiError setting (1 = show error on display, 0 = keep existing content)
+      case ResponseHeader::ShowNoWifiError:
+      {
+        uint8_t showNoWifiError = strtoul(value, nullptr, 10);
+        StateManager::setShowNoWifiError(showNoWifiError);
+        Logger::log<Logger::Topic::HEADER>("ShowNoWifiError: {}\n", showNoWifiError);
+      }
+      break;
+
+      // Firmware update URL
+      case ResponseHeader::OtaUpdate:
+        strncpy(m_otaUrl, value, sizeof(m_otaUrl) - 1);
+        m_otaUrl[sizeof(m_otaUrl) - 1] = '\0';
+        m_otaRequired = m_otaUrl[0] != '\0';
+        Logger::log<Logger::Topic::HEADER>("OTA Update requested: {}\n", m_otaUrl);
+        break;
+
+      case ResponseHeader::ContentLength:
+        contentLength = strtol(value, nullptr, 10);
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("Content-Length: {}\n", contentLength);
+        break;
+
+      case ResponseHeader::Connection:
+        if (strcasecmp(value, "close") == 0)
+          m_serverClose = true;
+        else if (strcasecmp(value, "keep-alive") == 0)
+          m_serverClose = false;
+        break;
+
+      case ResponseHeader::TransferEncoding:
+        chunked = isChunkedEncoding(value);
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("Transfer-Encoding: {}\n", value);
+        break;
+
+      case ResponseHeader::ContentHash:
+        // Compared as an opaque string, too long values are ignored
+        if (strlen(value) <= StateManager::CONTENT_HASH_MAX_LENGTH)
+          strcpy(m_contentHash, value);
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("X-Content-Hash: {}\n", m_contentHash);
+        break;
+
+      case ResponseHeader::ContentRange:
+        // "bytes start-end/total", only the start matters
+        if (strncasecmp(value, "bytes ", 6) == 0)
+          contentRangeStart = strtoull(value + 6, nullptr, 10);
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("Content-Range: {}\n", value);
+        break;
+
+      case ResponseHeader::RowRange:
+      {
+        // "first-last" (inclusive), the body then holds only these rows
+        char *end = nullptr;
+        unsigned long first = strtoul(value, &end, 10);
+        unsigned long last = (*end == '-') ? strtoul(end + 1, nullptr, 10) : 0;
+        if (*end == '-' && last >= first)
+        {
+          m_rowRangeFirst = first;
+          m_rowRangeCount = last - first + 1;
+        }
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("X-Row-Range: {}\n", value);
+        break;
+      }
+
+      case ResponseHeader::ContentEncoding:
+        Logger::log<Logger::Level::DEBUG, Logger::Topic::HEADER>("Content-Encoding: {}\n", value);
+        if (strcasecmp(value, "identity") == 0)
+          break;
+        encoded = true;
+        if (!parseContentEncoding(value, &encoding))
+        {
+          Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Unsupported Content-Encoding: {}\n", value);
+          connectionOk = false;
+        }
+        break;
+    }
+  }
+
+  // Body reads are de-chunked (or limited to Content-Length) from here on, never applied to the headers themselves
+  m_chunked = chunked;
+  m_contentLength = contentLength;
+
+  // Body offsets count from the first byte after the headers, a partial response starts at its range
+  m_bodyOffset = 0;
+  if (m_partialContent)
+  {
+    if (contentRangeStart != (int64_t)m_rangeStart)
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Content-Range does not start at {}\n", m_rangeStart);
+      connectionOk = false;
+    }
+    m_bodyOffset = m_rangeStart;
+  }
+  m_bodyStart = m_bodyOffset;
+
+  // Is there a problem? Fallback to default deep sleep time to try again soon
+  if (!connectionOk)
+  {
+    m_sleepDuration = StateManager::DEFAULT_SLEEP_SECONDS;
+    return false;
+  }
+
+  // For debug purposes - print out the whole response
+  /*
+  String data = "";
+  while (m_client.connected() || m_client.available()) {
+    if (m_client.available()) {
+      data += m_client.read();  // Read one byte
+    }
+  }
+  m_client.stop();
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Byte by byte:{}\n", data);
+  /* */
+
+  // If checking timestamp, see if content changed
+  if (checkTimestampOnly)
+  {
+    // Always save sleep duration from server, even if no update is needed
+    StateManager::setSleepDuration(m_sleepDuration);
+
+    if (foundTimestamp && (m_serverTimestamp == storedTimestamp))
+    {
+      Logger::log<Logger::Topic::HTTP>("No screen reload, still at current timestamp: {}\n", storedTimestamp);
+
+      StateManager::setLastRefreshDuration(0);
+
+      return false;
+    }
+
+    // New timestamp, but the server rendered the very same image to be shown the same way - skip both
+    // download and refresh
+    if (!m_otaRequired && StateManager::isContentUnchanged(m_contentHash, getRenderSettings()))
+    {
+      Logger::log<Logger::Topic::HTTP>("No screen reload, content unchanged (hash {})\n", m_contentHash);
+
+      StateManager::setTimestamp(m_serverTimestamp);
+      StateManager::setLastRefreshDuration(0);
+
+      return false;
+    }
+
+    // Set timestamp and content hash to actual ones
+    StateManager::setTimestamp(m_serverTimestamp);
+    StateManager::setContentHash(m_contentHash, getRenderSettings());
+  }
+
+  // Window is allocated only now that the body will be read, before the decoders size their buffers
+  if (encoded && !m_inflate.begin(encoding))
+  {
+    m_sleepDuration = StateManager::DEFAULT_SLEEP_SECONDS;
+    return false;
+  }
+
+  return true;
+}
+
+#ifdef USE_UDP_CHECK
+// Timestamp check over UDP, true if the content is unchanged and the HTTPS exchange can be skipped
+bool HttpClient::checkOverUdp()
+{
+  // Full telemetry only goes over HTTPS
+  collectTelemetry();
+  if (m_fullTelemetry)
+    return false;
+
+  uint32_t address = 0;
+  #ifdef UDP_CHECK_HOST
+  IPAddress resolved;
+  if (WiFi.hostByName(UDP_CHECK_HOST, resolved))
+    address = resolved;
+  #else
+  uint32_t addresses[DNS_CACHE_ADDRESSES];
+  bool fromCache;
+  if (resolveHost(addresses, true, fromCache) > 0)
+    address = addresses[0];
+  #endif
+  if (address == 0)
+    return false;
+
+  uint64_t storedTimestamp = StateManager::getTimestamp();
+  UdpCheck::Reply reply;
+  if (!UdpCheck::query(IPAddress(address), storedTimestamp, m_telemetry, reply))
+    return false;
+
+  if (reply.httpsRequired || reply.timestamp != storedTimestamp)
+  {
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("UDP check: {}, continuing over HTTPS\n",
+                                                           reply.httpsRequired ? "server asks for HTTPS" : "changed");
+    return false;
+  }
+
+  m_serverTimestamp = reply.timestamp;
+  if (reply.sleepSeconds > 0)
+    m_sleepDuration = reply.sleepSeconds;
+  StateManager::setSleepDuration(m_sleepDuration);
+  StateManager::setLastRefreshDuration(0);
+
+  // Server got the compact values, counts like a compact HTTPS request
+  StateManager::recordTelemetrySent(false, m_telemetry);
+  m_telemetryRecorded = true;
+
+  Logger::log<Logger::Topic::HTTP>("No screen reload, still at current timestamp: {} (UDP)\n", storedTimestamp);
+  return true;
+}
+#endif
+
+bool HttpClient::checkForUpdate(bool timestampCheck, bool keepConnectionOpen)
+{
+  m_imageDataReady = false;
+  m_requestFirstRow = 0;
+  m_requestRowCount = 0;
+
+#ifdef USE_UDP_CHECK
+  if (timestampCheck && checkOverUdp())
+    return false;
+#endif
+
+  if (!sendRequest(timestampCheck))
+    return false;
+
+  if (!parseHeaders(true, StateManager::getTimestamp()))
+  {
+    m_client.stop();
+    return false;
+  }
+
+  // Update sleep duration from headers
+  StateManager::setSleepDuration(m_sleepDuration);
+
+  // Update available, the response carries the new image
+  recordImageLatency();
+
+  // If keepConnectionOpen is requested, don't close - image data is ready to read
+  if (keepConnectionOpen)
+  {
+    beginBodyPhase();
+    m_imageDataReady = true;
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Connection kept open, image data ready\n");
+    return true; // Update available, connection open
+  }
+
+  m_client.stop();
+  resetBodyState();
+  return true; // Update available
+}
+
+bool HttpClient::startImageDownload(uint16_t firstRow, uint16_t rowCount)
+{
+  m_requestFirstRow = firstRow;
+  m_requestRowCount = rowCount;
+
+  if (!sendRequest(false))
+    return false;
+
+  if (!parseHeaders(false, 0))
+  {
+    m_client.stop();
+    return false;
+  }
+
+  recordImageLatency();
+
+  // Client stays open for image data
+  beginBodyPhase();
+  return true;
+}
+
+bool HttpClient::resumeDownload(uint32_t offset)
+{
+  if (m_inflate.isActive())
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Compressed body can't be resumed\n");
+    return false;
+  }
+
+  Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Resuming download at byte {}\n", offset);
+
+  m_client.stop();
+  m_rangeStart = offset;
+  bool ok = sendRequest(false) && parseHeaders(false, 0);
+  m_rangeStart = 0;
+
+  if (!ok)
+  {
+    m_client.stop();
+    return false;
+  }
+
+  // Server ignored the Range header and sent everything again, skip what was already decoded
+  if (!m_partialContent && offset > 0)
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Range not supported, skipping {} bytes\n", offset);
+    if (skip(offset) != offset)
+    {
+      m_client.stop();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool HttpClient::isBodyComplete() const
+{
+  if (m_bodyComplete)
+    return true;
+  return m_contentLength >= 0 && m_bodyOffset - m_bodyStart >= (uint32_t)m_contentLength;
+}
+
+bool HttpClient::isConnected()
+{
+  // Inflated output can still be pending after the last compressed byte arrived
+  if (m_inflate.isActive())
+    return m_inflate.buffered() > 0 || !m_inflate.isFinished();
+  return !m_bodyComplete && (rxBuffered() > 0 || m_client.connected() || m_client.available());
+}
+
+int HttpClient::available()
+{
+  if (m_inflate.isActive())
+    return m_inflate.buffered() + (m_inflate.isFinished() ? 0 : bodyBuffered() + m_client.available());
+  return m_bodyComplete ? 0 : bodyBuffered() + m_client.available();
+}
+
+void HttpClient::stop()
+{
+  endBodyPhase();
+  recordReceiveGap();
+  m_client.stop();
+  resetRxBuffer();
+  resetBodyState();
+  m_imageDataReady = false;
+}
+
+void HttpClient::beginBodyPhase()
+{
+  if (m_bodyPhaseActive)
+    return;
+
+  m_bodyPhaseActive = true;
+  m_powerPhaseStart = millis();
+  m_throughputWindowStart = m_powerPhaseStart;
+  m_throughputWindowBytes = 0;
+
+#ifdef DOWNLOAD_MODEM_SLEEP
+  m_powerSaveActive = Wireless::setDownloadPowerSave(true);
+#endif
+}
+
+// Called for every bulk read, leaves modem sleep if it costs too much throughput
+void HttpClient::updateThroughput(uint32_t bytes)
+{
+  if (!m_bodyPhaseActive)
+    return;
+
+  m_throughputWindowBytes += bytes;
+  m_phaseBodyBytes += bytes;
+  uint32_t now = millis();
+  uint32_t elapsed = now - m_throughputWindowStart;
+  if (elapsed < THROUGHPUT_WINDOW_MS)
+    return;
+
+  uint32_t bytesPerSecond = (uint64_t)m_throughputWindowBytes * 1000 / elapsed;
+  m_throughputWindowStart = now;
+  m_throughputWindowBytes = 0;
+
+  if (m_powerSaveActive && bytesPerSecond < DOWNLOAD_MODEM_SLEEP_MIN_THROUGHPUT)
+  {
+    Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>(
+      "Throughput {} B/s too low, back to the default power mode\n", bytesPerSecond);
+    m_powerSaveMs += now - m_powerPhaseStart;
+    m_powerPhaseStart = now;
+    m_powerSaveActive = false;
+    Wireless::setDownloadPowerSave(false);
+  }
+}
+
+// Stall and read size statistics, body data only (bytes is 0 for a wait that timed out)
+void HttpClient::recordRead(uint32_t bytes, uint32_t waitedMs)
+{
+  if (!m_bodyPhaseActive)
+    return;
+
+  if (waitedMs > DOWNLOAD_STALL_THRESHOLD_MS)
+  {
+    m_metrics.stallCount++;
+    m_metrics.stallMs += waitedMs;
+  }
+
+  if (bytes == 0)
+    return;
+
+  uint8_t bucket = (bytes < 128) ? 0 : (bytes < 512) ? 1 : (bytes < 1024) ? 2 : 3;
+  if (m_metrics.readSizes[bucket] < UINT16_MAX)
+    m_metrics.readSizes[bucket]++;
+}
+
+// Restore the default power mode and log time and estimated charge per download phase
+void HttpClient::endBodyPhase()
+{
+  if (!m_bodyPhaseActive)
+    return;
+
+  uint32_t now = millis();
+  if (m_powerSaveActive)
+  {
+    m_powerSaveMs += now - m_powerPhaseStart;
+    m_powerSaveActive = false;
+    Wireless::setDownloadPowerSave(false);
+  }
+  else
+  {
+    m_defaultModeMs += now - m_powerPhaseStart;
+  }
+  m_bodyPhaseActive = false;
+
+  // Too little data says more about latency than about the link
+  uint32_t bodyMs = m_powerSaveMs + m_defaultModeMs;
+  if (bodyMs > 0 && m_phaseBodyBytes >= DOWNLOAD_THROUGHPUT_MIN_BYTES)
+    StateManager::recordDownloadThroughput((uint64_t)m_phaseBodyBytes * 1000 / bodyMs);
+
+  // Totals so far in this wake, a later page overwrites them with larger ones
+  m_metrics.bodyMs += bodyMs;
+  m_metrics.bytes += m_phaseBodyBytes;
+  StateManager::setDownloadMetrics(m_metrics);
+
+  uint32_t activeMs = m_phaseConnectMs + m_phaseFirstByteMs + m_defaultModeMs;
+  uint32_t chargeMAs = (activeMs * WIFI_ACTIVE_CURRENT_MA + m_powerSaveMs * WIFI_MODEM_SLEEP_CURRENT_MA) / 1000;
+  Logger::log<Logger::Topic::HTTP>("Download phases: connect {} ms, first byte {} ms, body {} ms max modem sleep + "
+                                   "{} ms default mode, ~{} mAs\n",
+                                   m_phaseConnectMs, m_phaseFirstByteMs, m_powerSaveMs, m_defaultModeMs, chargeMAs);
+
+  m_phaseConnectMs = m_phaseFirstByteMs = m_powerSaveMs = m_defaultModeMs = m_phaseBodyBytes = 0;
+}
+
+void HttpClient::resetBodyState()
+{
+  m_chunked = false;
+  m_chunkRemaining = 0;
+  m_bodyComplete = false;
+  m_inflate.end();
+}
+
+// Refill receive buffer with one bulk read, waiting up to the idle timeout for data to arrive
+bool HttpClient::fillRxBuffer()
+{
+  resetRxBuffer();
+  uint32_t waitStart = millis();
+
+  while (m_client.connected() || m_client.available())
+  {
+    int avail = m_client.available();
+    if (avail > 0)
+    {
+      size_t toRead = ((size_t)avail < RX_BUFFER_SIZE) ? (size_t)avail : RX_BUFFER_SIZE;
+      int received = m_client.read(m_rxBuffer, toRead);
+      if (received > 0)
+      {
+        m_rxLen = received;
+
+        uint32_t gap = millis() - waitStart;
+        if (gap > m_maxReceiveGapMs)
+          m_maxReceiveGapMs = gap;
+
+        recordRead(received, gap);
+        updateThroughput(received);
+        return true;
+      }
+    }
+
+    uint32_t waited = millis() - waitStart;
+    if (waited > m_idleTimeoutMs)
+    {
+      Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Idle timeout after {} ms without data\n", waited);
+      m_maxReceiveGapMs = waited;
+      recordRead(0, waited);
+      return false;
+    }
+    waitForSocket(m_idleTimeoutMs - waited);
+  }
+
+  return false;
+}
+
+int16_t HttpClient::readRawByte()
+{
+  if (rxBuffered() == 0 && !fillRxBuffer())
+    return -1;
+  return m_rxBuffer[m_rxPos++];
+}
+
+// Read one line of chunk framing (size line or trailer) bypassing the body layer, CRLF stripped
+int32_t HttpClient::readRawLine(char *buf, size_t bufSize)
+{
+  size_t len = 0;
+  int16_t c;
+
+  while ((c = readRawByte()) >= 0 && c != '\n')
+  {
+    if (len < bufSize - 1)
+      buf[len++] = (char)c;
+  }
+
+  if (len > 0 && buf[len - 1] == '\r')
+    len--;
+  buf[len] = '\0';
+
+  return (c < 0) ? -1 : (int32_t)len;
+}
+
+// Parse the next chunk-size line, sets m_chunkRemaining or marks the body complete on the last chunk
+bool HttpClient::readChunkHeader()
+{
+  char line[CHUNK_LINE_BUFFER_SIZE];
+
+  // Previous chunk data is followed by an empty line
+  int32_t length = readRawLine(line, sizeof(line));
+  if (length == 0)
+    length = readRawLine(line, sizeof(line));
+
+  if (length <= 0)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Chunked body ended without final chunk\n");
+    return false;
+  }
+
+  // Chunk size in hex, optionally followed by ";extension"
+  char *end = nullptr;
+  unsigned long size = strtoul(line, &end, 16);
+  if (end == line)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Invalid chunk size line: {}\n", line);
+    return false;
+  }
+
+  if (size == 0)
+  {
+    // Last chunk, drain optional trailer headers up to the closing empty line
+    while (readRawLine(line, sizeof(line)) > 0)
+    {
+    }
+    m_bodyComplete = true;
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Chunked body complete\n");
+    return false;
+  }
+
+  m_chunkRemaining = size;
+  return true;
+}
+
+// Make sure at least one body byte is buffered, handling refills and chunk framing
+bool HttpClient::ensureBodyData()
+{
+  while (!m_bodyComplete)
+  {
+    // Content-Length reached, anything after it belongs to the next response
+    if (!m_chunked && m_contentLength >= 0 && bodyFrameRemaining() == 0)
+    {
+      m_bodyComplete = true;
+      break;
+    }
+
+    if (m_chunked && m_chunkRemaining == 0)
+    {
+      if (!readChunkHeader())
+        return false;
+      continue;
+    }
+
+    if (rxBuffered() > 0)
+      return true;
+
+    if (!fillRxBuffer())
+      return false;
+  }
+
+  return false;
+}
+
+// Body bytes left in the current framing unit (chunk or Content-Length), UINT32_MAX if the body is unframed
+uint32_t HttpClient::bodyFrameRemaining() const
+{
+  if (m_chunked)
+    return m_chunkRemaining;
+
+  if (m_contentLength >= 0)
+  {
+    uint32_t consumed = m_bodyOffset - m_bodyStart;
+    return (consumed < (uint32_t)m_contentLength) ? (uint32_t)m_contentLength - consumed : 0;
+  }
+
+  return UINT32_MAX;
+}
+
+size_t HttpClient::bodyBuffered() const
+{
+  size_t buffered = rxBuffered();
+  uint32_t frameRemaining = bodyFrameRemaining();
+  if (buffered > frameRemaining)
+    buffered = frameRemaining;
+  return buffered;
+}
+
+void HttpClient::consumeBody(size_t bytes)
+{
+  m_rxPos += bytes;
+  m_bodyOffset += bytes;
+  if (m_chunked)
+    m_chunkRemaining -= bytes;
+}
+
+// Make sure at least one decoded byte is buffered, inflating more of the body if it is encoded
+bool HttpClient::ensureData()
+{
+  if (!m_inflate.isActive())
+    return ensureBodyData();
+
+  while (m_inflate.buffered() == 0)
+  {
+    if (m_inflate.isFinished())
+      return false;
+
+    bool moreInput = ensureBodyData();
+    size_t used = moreInput ? bodyBuffered() : 0;
+    bool ok = m_inflate.decode(m_rxBuffer + m_rxPos, used, moreInput);
+    consumeBody(used);
+    if (!ok)
+      return false;
+  }
+
+  return true;
+}
+
+const uint8_t *HttpClient::dataPtr() const
+{
+  return m_inflate.isActive() ? m_inflate.data() : m_rxBuffer + m_rxPos;
+}
+
+size_t HttpClient::dataBuffered() const { return m_inflate.isActive() ? m_inflate.buffered() : bodyBuffered(); }
+
+void HttpClient::consumeData(size_t bytes)
+{
+  if (m_inflate.isActive())
+    m_inflate.consume(bytes);
+  else
+    consumeBody(bytes);
+}
+
+uint32_t HttpClient::readBytes(uint8_t *buf, int32_t bytes)
+{
+  int32_t remaining = bytes;
+  uint32_t startTime = millis();
+
+  while (remaining > 0)
+  {
+    if (!ensureData())
+      break;
+
+    size_t chunk = dataBuffered();
+    if (chunk > (size_t)remaining)
+      chunk = remaining;
+
+    if (buf)
+    {
+      memcpy(buf, dataPtr(), chunk);
+      buf += chunk;
+    }
+    consumeData(chunk);
+    remaining -= chunk;
+
     // Check total timeout
-    if (now - startTime > TOTAL_TIMEOUT_MS)
+    uint32_t now = millis();
+    if (remaining > 0 && now - startTime > m_totalTimeoutMs)
     {
       Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Total timeout after {} ms\n", now - startTime);
       break;
@@ -371,16 +1669,106 @@ uint32_t HttpClient::readBytes(uint8_t *buf, int32_t bytes)
   return bytes - remaining;
 }
 
+uint32_t HttpClient::readInto(uint8_t *buf, uint32_t maxBytes)
+{
+  if (maxBytes == 0 || !ensureData())
+    return 0;
+
+  // Hand out what is buffered first
+  size_t copied = dataBuffered();
+  if (copied > maxBytes)
+    copied = maxBytes;
+  memcpy(buf, dataPtr(), copied);
+  consumeData(copied);
+
+  // Top up straight from the client if more is already waiting, skipping the extra copy.
+  // Only while the receive buffer is drained, never past the end of the current chunk or Content-Length,
+  // and never for an encoded body.
+  if (copied < maxBytes && rxBuffered() == 0 && !m_inflate.isActive())
+  {
+    int avail = m_client.available();
+    size_t toRead = maxBytes - copied;
+    uint32_t frameRemaining = bodyFrameRemaining();
+    if (toRead > frameRemaining)
+      toRead = frameRemaining;
+    if ((size_t)avail < toRead)
+      toRead = (avail > 0) ? avail : 0;
+
+    if (toRead > 0)
+    {
+      int received = m_client.read(buf + copied, toRead);
+      if (received > 0)
+      {
+        recordRead(received, 0);
+        updateThroughput(received);
+        copied += received;
+        m_bodyOffset += received;
+        if (m_chunked)
+          m_chunkRemaining -= received;
+      }
+    }
+  }
+
+  return copied;
+}
+
+int32_t HttpClient::readUntil(char terminator, char *buf, size_t bufSize)
+{
+  size_t len = 0;
+
+  while (true)
+  {
+    if (!ensureData())
+    {
+      buf[len] = '\0';
+      return -1;
+    }
+
+    const uint8_t *start = dataPtr();
+    const uint8_t *found = (const uint8_t *)memchr(start, terminator, dataBuffered());
+    size_t segment = found ? (size_t)(found - start) : dataBuffered();
+
+    // Keep what fits, silently drop the rest of an overlong line
+    size_t room = bufSize - 1 - len;
+    size_t toCopy = (segment < room) ? segment : room;
+    memcpy(buf + len, start, toCopy);
+    len += toCopy;
+    consumeData(segment);
+
+    if (found)
+    {
+      consumeData(1); // Terminator
+      buf[len] = '\0';
+      return len;
+    }
+  }
+}
+
+int16_t HttpClient::peek()
+{
+  if (!ensureData())
+    return -1;
+  return *dataPtr();
+}
+
 uint8_t HttpClient::readByte()
 {
-  uint8_t result;
+  // Fast path straight from the receive buffer (or inflate window)
+  if (dataBuffered() > 0)
+  {
+    uint8_t result = *dataPtr();
+    consumeData(1);
+    return result;
+  }
+
+  uint8_t result = 0;
   readBytes(&result, 1);
   return result;
 }
 
 uint8_t HttpClient::readByteValid(bool *valid)
 {
-  uint8_t result;
+  uint8_t result = 0;
   *valid = readBytes(&result, 1) == 1;
   return result;
 }
@@ -395,7 +1783,7 @@ uint16_t HttpClient::read16()
 
 bool HttpClient::performOTAUpdate()
 {
-  if (!m_otaRequired || m_otaUrl.length() == 0)
+  if (!m_otaRequired || m_otaUrl[0] == '\0')
   {
     Logger::log<Logger::Level::WARNING, Logger::Topic::SYSTEM>("No OTA update URL available\n");
     return false;
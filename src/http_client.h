@@ -16,10 +16,19 @@
   #define CONNECTION_URL_PREFIX "https://"
 #endif
 
+// Transparent gzip/deflate Content-Encoding of the image body - enabled by default
+#ifndef HTTP_COMPRESSION_DISABLED
+  #define HTTP_COMPRESSION_ENABLED
+#endif
+
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
 
+#include "inflate_stream.h"
+#include "sensor.h"
+#include "state_manager.h"
+
 class HttpClient
 {
 public:
@@ -34,7 +43,30 @@ public:
 
   // Start downloading image (call after checkForUpdate returns true)
   // Not needed if checkForUpdate was called with keepConnectionOpen=true
-  bool startImageDownload();
+  // With rowCount > 0 only rows firstRow..firstRow+rowCount-1 are requested (paged mode)
+  bool startImageDownload(uint16_t firstRow = 0, uint16_t rowCount = 0);
+
+  // Rows contained in the image body, from X-Row-Range; false if the server sent the whole image
+  bool getRowRange(uint16_t &firstRow, uint16_t &rowCount) const
+  {
+    firstRow = m_rowRangeFirst;
+    rowCount = m_rowRangeCount;
+    return m_rowRangeCount > 0;
+  }
+
+  // Reconnect after a dropped connection and continue the image body at offset (HTTP Range)
+  // Falls back to skipping already received bytes if the server answers with the full body.
+  // Not possible for a compressed body, offsets count raw bytes and the inflate state is lost.
+  bool resumeDownload(uint32_t offset);
+
+  // Body bytes consumed so far, counted from the start of the image response body
+  uint32_t getBodyOffset() const { return m_bodyOffset; }
+
+  // Whole body received (chunked end marker or Content-Length reached)
+  bool isBodyComplete() const;
+
+  // Keep the socket open between requests (paged mode), the server may still close it
+  void setKeepAlive(bool enable) { m_keepAlive = enable; }
 
   // Connection status
   bool isConnected();
@@ -52,24 +84,52 @@ public:
 
   bool hasPartialRefresh() const { return m_partialRefresh; }
 
+  // Rotation and refresh mode requested by the server, stored with the content hash
+  uint16_t getRenderSettings() const
+  {
+    return (m_hasRotation ? (0x100 | m_displayRotation) : 0) | (m_partialRefresh ? 0x200 : 0);
+  }
+
   bool hasOTAUpdate() const { return m_otaRequired; }
 
-  String getOTAUrl() const { return m_otaUrl; }
+  const char *getOTAUrl() const { return m_otaUrl; }
+
+  // Heap to leave free while the body is read. The TLS record buffers are allocated with the connection,
+  // before the band is sized, so HTTPS needs no more than plain HTTP here.
+  static constexpr size_t getReadHeapReserve() { return READ_HEAP_OVERHEAD; }
 
   // Perform OTA firmware update if requested by server
   // Returns true if OTA was successful (device will restart), false on failure
   bool performOTAUpdate();
 
   // Data reading methods - no WiFiClient exposure!
+  // All reads are served from an internal receive buffer refilled with bulk socket reads,
+  // or from the inflate window when the body has a Content-Encoding
   uint32_t readBytes(uint8_t *buf, int32_t bytes);
 
   uint32_t skip(int32_t bytes) { return readBytes(nullptr, bytes); }
 
+  // Read whatever is already received (waits only for the first byte), up to maxBytes
+  uint32_t readInto(uint8_t *buf, uint32_t maxBytes);
+
+  // Read until terminator (consumed, not stored) into null-terminated buf, overflow is discarded
+  // Returns stored length, or -1 if data ended before the terminator was found
+  int32_t readUntil(char terminator, char *buf, size_t bufSize);
+
+  // Next byte without consuming it, -1 if no more data
+  int16_t peek();
+
   uint8_t readByte();
   uint8_t readByteValid(bool *valid);
   uint16_t read16();
 
 private:
+  static constexpr size_t READ_HEAP_OVERHEAD = 10 * 1024;
+
+  // Fixed buffers for response header parsing
+  static constexpr size_t HEADER_LINE_BUFFER_SIZE = 384;
+  static constexpr size_t OTA_URL_BUFFER_SIZE = 320;
+
 #ifdef USE_CLIENT_HTTP
   WiFiClient m_client;
 #else
@@ -83,15 +143,119 @@ private:
   bool m_hasRotation;
   bool m_partialRefresh;
   bool m_otaRequired;
-  String m_otaUrl;
+  char m_otaUrl[OTA_URL_BUFFER_SIZE];
+  char m_contentHash[StateManager::CONTENT_HASH_MAX_LENGTH + 1]; // Empty if not sent by server
+  int32_t m_contentLength; // -1 if not sent by server
   bool m_imageDataReady;
-  String m_jsonPayload;
-  JsonDocument m_jsonDoc;
+  JsonDocument m_jsonDoc; // Only holds data while a request is being sent
+
+  // Receive buffer, refilled in bulk from the client
+  static constexpr size_t RX_BUFFER_SIZE = 1024;
+  uint8_t m_rxBuffer[RX_BUFFER_SIZE];
+  size_t m_rxPos;
+  size_t m_rxLen;
+
+  // Body framing (chunked transfer-encoding is de-chunked transparently in the read path)
+  static constexpr size_t CHUNK_LINE_BUFFER_SIZE = 32;
+  bool m_chunked;
+  uint32_t m_chunkRemaining;
+  bool m_bodyComplete;
+
+  // Content-Encoding layer between body framing and the read methods, active only for encoded bodies
+  InflateStream m_inflate;
+
+  // Only the first connection of a wake is stored as handshake duration
+  bool m_handshakeRecorded;
+  uint32_t m_lastHandshakeMs; // TLS phase of the last connect, 0 without TLS
+
+  // Compact or full telemetry in this wake's payload
+  StateManager::TelemetrySnapshot m_telemetry;
+  bool m_fullTelemetry;
+  bool m_telemetryRecorded;
+  bool m_telemetryCollected;
+#ifdef SENSOR
+  SensorData m_sensorData;
+#endif
+
+  // Body position for resuming interrupted downloads
+  uint32_t m_bodyOffset;
+  uint32_t m_bodyStart;  // Offset of the first byte in this response (non-zero for 206)
+  uint32_t m_rangeStart; // Range requested by resumeDownload, 0 for a normal request
+  bool m_partialContent;
+
+  // Row range requested by startImageDownload and the one reported by the server
+  uint16_t m_requestFirstRow;
+  uint16_t m_requestRowCount;
+  uint16_t m_rowRangeFirst;
+  uint16_t m_rowRangeCount;
+
+  // Keep-alive between requests
+  static constexpr uint32_t KEEP_ALIVE_MAX_DRAIN = 4096; // Larger leftovers are cheaper to drop with the socket
+  bool m_keepAlive;
+  bool m_serverClose; // Last response said (or implied) the server closes the connection
+
+  // Adaptive timeouts, derived from latency history before each request
+  uint32_t m_firstByteTimeoutMs;
+  uint32_t m_idleTimeoutMs;
+  uint32_t m_totalTimeoutMs;
+  uint32_t m_maxReceiveGapMs; // Longest wait for data in the current response
+  uint32_t m_lastFirstByteMs; // First-byte latency of the current response, see recordImageLatency
+
+  // Download power mode and per-phase timing (see DOWNLOAD_MODEM_SLEEP)
+  bool m_bodyPhaseActive;
+  bool m_powerSaveActive;
+  uint32_t m_powerPhaseStart;
+  uint32_t m_throughputWindowStart;
+  uint32_t m_throughputWindowBytes;
+  uint32_t m_phaseConnectMs;
+  uint32_t m_phaseFirstByteMs;
+  uint32_t m_powerSaveMs;
+  uint32_t m_defaultModeMs;
+  uint32_t m_phaseBodyBytes;
+
+  // Network metrics summed over this wake's requests, stored for the next wake after each download
+  StateManager::DownloadMetrics m_metrics;
+  bool m_metricsIncluded; // Previous wake's metrics are part of the payload being sent
 
   // Internal helpers
+  void collectTelemetry();
   void buildJsonPayload();
+#ifdef USE_UDP_CHECK
+  bool checkOverUdp();
+#endif
+  uint8_t resolveHost(uint32_t *addresses, bool useCache, bool &fromCache);
+  void addDownloadMetrics(JsonObject network);
   bool sendRequest(bool timestampCheck);
+  bool openConnection(bool timestampCheck);
+  bool reuseConnection();
+  void writeRequest(bool timestampCheck);
+  bool waitForResponse();
+  void waitForSocket(uint32_t timeoutMs);
+  void updateTimeouts();
+  void recordImageLatency();
+  void recordReceiveGap();
+  void beginBodyPhase();
+  void updateThroughput(uint32_t bytes);
+  void endBodyPhase();
+  void recordRead(uint32_t bytes, uint32_t waitedMs);
+  bool connectToHost();
+  bool connectAddress(uint32_t address);
   bool parseHeaders(bool checkTimestampOnly, uint64_t storedTimestamp);
+  bool fillRxBuffer();
+  void resetRxBuffer() { m_rxPos = m_rxLen = 0; }
+  size_t rxBuffered() const { return m_rxLen - m_rxPos; }
+  void resetBodyState();
+  int16_t readRawByte();
+  int32_t readRawLine(char *buf, size_t bufSize);
+  bool readChunkHeader();
+  bool ensureBodyData();
+  uint32_t bodyFrameRemaining() const;
+  size_t bodyBuffered() const;
+  void consumeBody(size_t bytes);
+  bool ensureData();
+  const uint8_t *dataPtr() const;
+  size_t dataBuffered() const;
+  void consumeData(size_t bytes);
 };
 
 #endif // HTTP_CLIENT_H
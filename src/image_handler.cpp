@@ -10,6 +10,9 @@
  * - Z1:  ZivyObraz RLE format (1 byte color + 1 byte count)
  * - Z2:  ZivyObraz RLE format (2-bit color + 6-bit count) - Most efficient
  * - Z3:  ZivyObraz RLE format (3-bit color + 5-bit count)
+ * - Z4:  ZivyObraz RLE format (3-bit color + varint count, row repeats)
+ * - ZP:  Rows pre-packed in the native display layout, copied without decoding
+ * - ZL:  ZP rows with literal/back-reference records into a window of recent rows
  *
  * Modes:
  * - Paged mode: Traditional page-by-page drawing (backward compatible)
@@ -19,6 +22,7 @@
 #include "image_handler.h"
 
 #include "display.h"
+#include "network_reader.h"
 #include "pixel_packer.h"
 #include "logger.h"
 #include "state_manager.h"
@@ -55,7 +59,10 @@ enum class ImageFormat : uint16_t
   PNG = 0x5089, // PNG signature (first 2 bytes: 0x89 0x50)
   Z1 = 0x315A,  // Z1: 1 byte color + 1 byte count
   Z2 = 0x325A,  // Z2: 2-bit color + 6-bit count
-  Z3 = 0x335A   // Z3: 3-bit color + 5-bit count
+  Z3 = 0x335A,  // Z3: 3-bit color + 5-bit count
+  Z4 = 0x345A,  // Z4: 3-bit color + varint count runs, row-repeat opcodes (see decodeZ4Record)
+  ZP = 0x505A,  // ZP: rows pre-packed in the native display layout (see readPackedHeader)
+  ZL = 0x4C5A   // ZL: ZP rows with back-references into recent rows (see decodeZLRecord)
 };
 
 ///////////////////////////////////////////////
@@ -74,11 +81,24 @@ static const char *formatToString(ImageFormat format)
       return "Z2";
     case ImageFormat::Z3:
       return "Z3";
+    case ImageFormat::Z4:
+      return "Z4";
+    case ImageFormat::ZP:
+      return "ZP";
+    case ImageFormat::ZL:
+      return "ZL";
     default:
       return "Unknown";
   }
 }
 
+// Formats recognized by scanForImageHeader, advertised to the server in this order
+static const ImageFormat SUPPORTED_FORMATS[] = {ImageFormat::Z4,
+#ifndef TYPE_8G // No packed layout for epdiy grayscale
+                                                ImageFormat::ZL, ImageFormat::ZP,
+#endif
+                                                ImageFormat::Z2, ImageFormat::Z3, ImageFormat::Z1, ImageFormat::PNG};
+
 static void printReadError(uint32_t bytesRead)
 {
   Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Client got disconnected after bytes: {}\n", bytesRead);
@@ -87,6 +107,23 @@ static void printReadError(uint32_t bytesRead)
 // Maximum bytes to scan for image header (4 KB)
 static const uint16_t MAX_HEADER_SCAN_BYTES = 4096;
 
+// Reconnects per image when the connection drops mid-download
+static const uint8_t MAX_RESUME_ATTEMPTS = 3;
+
+// Body ended early - reconnect and continue at offset, unless the server already sent everything.
+// Decoder state (row, column, row buffer) stays as is, offset points at the first byte not yet decoded.
+// Source is HttpClient (paged mode) or NetworkReader (direct mode).
+template <typename Source> static bool resumeImageDownload(Source &source, uint32_t offset, uint8_t &attempts)
+{
+  if (source.isBodyComplete() || attempts >= MAX_RESUME_ATTEMPTS)
+    return false;
+
+  attempts++;
+  Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>("Connection lost, resume attempt {}/{}\n", attempts,
+                                                            MAX_RESUME_ATTEMPTS);
+  return source.resumeDownload(offset);
+}
+
 // Check if a 16-bit value is a valid image format header
 static bool isValidFormatHeader(uint16_t header)
 {
@@ -96,6 +133,11 @@ static bool isValidFormatHeader(uint16_t header)
     case ImageFormat::Z1:
     case ImageFormat::Z2:
     case ImageFormat::Z3:
+    case ImageFormat::Z4:
+#ifndef TYPE_8G // Not advertised, see SUPPORTED_FORMATS
+    case ImageFormat::ZP:
+    case ImageFormat::ZL:
+#endif
       return true;
     default:
       return false;
@@ -162,7 +204,8 @@ static bool scanForImageHeader(HttpClient &http, uint16_t &outHeader)
   // We've already read 2 bytes, scan up to MAX_HEADER_SCAN_BYTES - 2 more
   for (uint16_t offset = 2; offset < MAX_HEADER_SCAN_BYTES; offset++)
   {
-    if (!http.isConnected() || http.available() <= 0)
+    // Wait for more data instead of giving up on a momentarily empty socket
+    if (http.peek() < 0)
     {
       flushBuffer();
       Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>(" <<<\n");
@@ -260,6 +303,365 @@ static uint16_t mapColorValue(uint8_t pixelColor, uint16_t color2, uint16_t colo
   }
 }
 
+///////////////////////////////////////////////
+// Z4 Records
+///////////////////////////////////////////////
+
+static const uint8_t VARINT_MAX_BYTES = 4;
+static const uint32_t VARINT_INVALID = UINT32_MAX;
+
+// Decode a LEB128 varint (7 bits per byte, low group first, high bit set while more bytes follow),
+// returns its size in bytes, 0 when it continues past length or VARINT_INVALID when it is longer than any image needs
+static uint32_t decodeVarint(const uint8_t *data, uint32_t length, uint32_t &value)
+{
+  value = 0;
+  for (uint32_t i = 0; i < VARINT_MAX_BYTES; i++)
+  {
+    if (i >= length)
+      return 0;
+
+    value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+    if ((data[i] & 0x80) == 0)
+      return i + 1;
+  }
+
+  return VARINT_INVALID;
+}
+
+// Z4 opcodes, one byte optionally followed by a varint:
+//   0cccnnnn  run of palette color ccc: n + 1 pixels (1-15), n = 15: 16 + varint pixels, may wrap rows
+//   10rrrrrr  repeat the previous row: r + 1 rows (1-63), r = 63: 64 + varint rows, only at a row start
+//   11xxxxxx  reserved, the image is rejected
+enum class Z4Op : uint8_t
+{
+  Run,
+  RepeatRows,
+  Invalid
+};
+
+struct Z4Record
+{
+  Z4Op op;
+  uint8_t color;  // Palette index (Run)
+  uint32_t count; // Pixels (Run) or rows (RepeatRows)
+};
+
+// Decode one Z4 record, returns its size in bytes or 0 when it continues past length
+static uint32_t decodeZ4Record(const uint8_t *data, uint32_t length, Z4Record &record)
+{
+  uint8_t opcode = data[0];
+  uint8_t base, extended;
+
+  if ((opcode & 0x80) == 0)
+  {
+    record.op = Z4Op::Run;
+    record.color = (opcode >> 4) & 0x07;
+    base = opcode & 0x0F;
+    extended = 0x0F;
+  }
+  else if ((opcode & 0x40) == 0)
+  {
+    record.op = Z4Op::RepeatRows;
+    record.color = 0;
+    base = opcode & 0x3F;
+    extended = 0x3F;
+  }
+  else
+  {
+    record.op = Z4Op::Invalid;
+    return 1;
+  }
+
+  if (base != extended)
+  {
+    record.count = base + 1;
+    return 1;
+  }
+
+  uint32_t value;
+  uint32_t varintSize = decodeVarint(data + 1, length - 1, value);
+  if (varintSize == 0)
+    return 0;
+  if (varintSize == VARINT_INVALID)
+  {
+    record.op = Z4Op::Invalid;
+    return 1;
+  }
+
+  record.count = extended + 1 + value;
+  return 1 + varintSize;
+}
+
+///////////////////////////////////////////////
+// ZP Header
+///////////////////////////////////////////////
+
+// ZP stream after the magic: native format (PixelPacker::DisplayFormat value, "nativeFormat" capability),
+// bits per pixel per plane, row width in pixels (u16 LE), all three must match the display. Rows follow in
+// PixelPacker layout, each one getRowBufferSize() bytes per plane, 3C sends the black plane row then the color
+// plane row. Not on 8G builds, epdiy grayscale has no packed layout.
+static const uint8_t PACKED_HEADER_SIZE = 4;
+
+static bool readPackedHeader(HttpClient &http, uint16_t width)
+{
+  uint8_t header[PACKED_HEADER_SIZE];
+  uint32_t headerRead = http.readBytes(header, sizeof(header));
+  if (headerRead != sizeof(header))
+  {
+    printReadError(2 + headerRead);
+    return false;
+  }
+
+  uint16_t streamWidth = header[2] | (header[3] << 8);
+  if (header[0] != static_cast<uint8_t>(PixelPacker::getDisplayFormat()) ||
+      header[1] != PixelPacker::NATIVE_BITS_PER_PIXEL || streamWidth != width)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>(
+      "ZP layout mismatch: stream format {}, {} bpp, {} px; display {}, {} bpp, {} px\n", header[0], header[1],
+      streamWidth, static_cast<uint8_t>(PixelPacker::getDisplayFormat()), PixelPacker::NATIVE_BITS_PER_PIXEL, width);
+    return false;
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////
+// ZL Records
+///////////////////////////////////////////////
+
+// ZL stream: the ZP layout header, window rows (u16 LE), then records that decode to the ZP row stream:
+//   0nnnnnnn [varint]           n + 1 literal bytes follow (1-127), n = 127: 128 + varint
+//   1nnnnnnn [varint] distance  copy n + 3 bytes from distance (varint, >= 1) bytes back (3-129),
+//                               n = 127: 130 + varint. A distance below the length repeats the last bytes.
+// Every copied byte reaches the window rows before its row plus the decoded part of its row. Reaching further,
+// also once a match continues into the next row, rejects the image.
+// The window lives in the row memory itself (the band in direct mode), so window rows have to stay below the
+// band height ("bandRows" capability) and the image height, 7 always fits as bands have at least 8 rows.
+struct ZLRecord
+{
+  bool match;
+  bool valid;
+  uint32_t length;
+  uint32_t distance; // Match only
+};
+
+// Decode one ZL record header, returns its size in bytes or 0 when it continues past length
+static uint32_t decodeZLRecord(const uint8_t *data, uint32_t length, ZLRecord &record)
+{
+  uint8_t opcode = data[0];
+  uint32_t size = 1;
+
+  record.match = (opcode & 0x80) != 0;
+  record.valid = true;
+  record.length = (opcode & 0x7F) + (record.match ? 3 : 1);
+  record.distance = 0;
+
+  if ((opcode & 0x7F) == 0x7F)
+  {
+    uint32_t value;
+    uint32_t varintSize = decodeVarint(data + size, length - size, value);
+    if (varintSize == 0)
+      return 0;
+    if (varintSize == VARINT_INVALID)
+    {
+      record.valid = false;
+      return 1;
+    }
+    record.length += value;
+    size += varintSize;
+  }
+
+  if (record.match)
+  {
+    uint32_t varintSize = decodeVarint(data + size, length - size, record.distance);
+    if (varintSize == 0)
+      return 0;
+    if (varintSize == VARINT_INVALID || record.distance == 0)
+    {
+      record.valid = false;
+      return 1;
+    }
+    size += varintSize;
+  }
+
+  return size;
+}
+
+static bool readWindowRows(HttpClient &http, uint16_t &windowRows)
+{
+  uint8_t header[2];
+  if (http.readBytes(header, sizeof(header)) != sizeof(header))
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Missing window size\n");
+    return false;
+  }
+
+  windowRows = header[0] | (header[1] << 8);
+  return true;
+}
+
+// Decode ZL records into Rows, which hold the decoded rows and double as the back-reference window:
+//   rowBytes(), capacity() in rows, at(pos, contiguous) for the memory at a stream position,
+//   output(count) for rows [0, count) and moveToFront(first, count).
+// Work per output byte is bounded: literals are one memcpy, matches one copy per contiguous stretch.
+// Returns the number of complete rows output, valid is false after a malformed record.
+template <typename Source, typename Rows>
+static uint16_t decodeZLRows(Source &source, Rows &rows, uint16_t rowCount, uint16_t windowRows, uint8_t *buffer,
+                             uint16_t bufferSize, uint32_t &bytes_read, bool &valid)
+{
+  const uint32_t rowBytes = rows.rowBytes();
+  const uint32_t capacity = (uint32_t)rows.capacity() * rowBytes;
+  const uint32_t totalBytes = (uint32_t)rowCount * rowBytes;
+  const uint32_t windowBytes = (uint32_t)windowRows * rowBytes;
+
+  // At least one row past the window, otherwise nothing is ever output and the window can't move
+  if (rows.capacity() <= windowRows)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Window of {} rows needs more than {} rows\n",
+                                                            windowRows, rows.capacity());
+    valid = false;
+    return 0;
+  }
+
+  uint32_t produced = 0; // Decoded bytes in total
+  uint32_t pos = 0;      // Decoded bytes held by rows, the available history
+  uint16_t rowsOut = 0;
+  uint32_t literal = 0;
+  uint32_t match = 0;
+  uint32_t distance = 0;
+
+  uint32_t bufferPos = 0;
+  uint32_t bufferAvailable = 0;
+  uint8_t resumeAttempts = 0;
+  valid = true;
+
+  while (produced < totalBytes)
+  {
+    // Rows full: hand out all but the window rows, those move to the front as history
+    uint32_t remaining = totalBytes - produced;
+    if (pos == capacity)
+    {
+      uint16_t outRows = rows.capacity() - windowRows;
+      rows.output(outRows);
+      rows.moveToFront(outRows, windowRows);
+      rowsOut += outRows;
+      pos = windowBytes;
+    }
+
+    // Each new row drops the oldest window row, an ongoing match has to stay within the window too.
+    // After moveToFront exactly the window rows are held, so this also keeps pos - distance in range.
+    if (match > 0 && pos % rowBytes == 0 && distance > windowBytes)
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Match at byte {} reaches past the window\n",
+                                                              produced);
+      valid = false;
+      break;
+    }
+
+    if (match > 0)
+    {
+      uint32_t dstSpace, srcSpace;
+      uint8_t *dst = rows.at(pos, dstSpace);
+      const uint8_t *src = rows.at(pos - distance, srcSpace);
+      uint32_t rowSpace = rowBytes - pos % rowBytes; // Up to the next row, the reach is checked again there
+      uint32_t count = (match < remaining) ? match : remaining;
+      count = (count < dstSpace) ? count : dstSpace;
+      count = (count < srcSpace) ? count : srcSpace;
+      count = (count < rowSpace) ? count : rowSpace;
+
+      if (count <= distance)
+        memcpy(dst, src, count);
+      else
+        for (uint32_t i = 0; i < count; i++)
+          dst[i] = src[i]; // Overlapping, repeats the last distance bytes
+
+      pos += count;
+      produced += count;
+      match -= count;
+      continue;
+    }
+
+    ZLRecord record;
+    uint32_t recordSize = 0;
+    if (bufferPos < bufferAvailable)
+    {
+      if (literal > 0)
+      {
+        uint32_t dstSpace;
+        uint8_t *dst = rows.at(pos, dstSpace);
+        uint32_t count = (literal < remaining) ? literal : remaining;
+        count = (count < dstSpace) ? count : dstSpace;
+        count = (count < bufferAvailable - bufferPos) ? count : bufferAvailable - bufferPos;
+
+        memcpy(dst, buffer + bufferPos, count);
+        bufferPos += count;
+        pos += count;
+        produced += count;
+        literal -= count;
+        continue;
+      }
+
+      recordSize = decodeZLRecord(buffer + bufferPos, bufferAvailable - bufferPos, record);
+    }
+
+    if (recordSize == 0)
+    {
+      // Carry over the start of a record that straddles reads
+      uint32_t leftover = bufferAvailable - bufferPos;
+      memmove(buffer, buffer + bufferPos, leftover);
+
+      uint32_t bytesRead = 0;
+      if (source.isConnected() || source.available())
+        bytesRead = source.readInto(buffer + leftover, bufferSize - leftover);
+
+      if (bytesRead == 0)
+      {
+        // Partial record is requested again together with the rest
+        if (resumeImageDownload(source, source.getBodyOffset() - leftover, resumeAttempts))
+        {
+          bufferPos = bufferAvailable = 0;
+          continue;
+        }
+        break;
+      }
+
+      bufferPos = 0;
+      bytes_read += bytesRead;
+      bufferAvailable = leftover + bytesRead;
+      continue;
+    }
+
+    bufferPos += recordSize;
+
+    // Reach: the window rows before the current row plus its decoded part, and never before the first byte
+    uint32_t reach = windowBytes + pos % rowBytes;
+    reach = (reach < pos) ? reach : pos;
+
+    if (!record.valid || record.distance > reach)
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Invalid record at byte {} (distance {})\n",
+                                                              produced, record.distance);
+      valid = false;
+      break;
+    }
+
+    if (record.match)
+    {
+      match = record.length;
+      distance = record.distance;
+    }
+    else
+    {
+      literal = record.length;
+    }
+  }
+
+  // Remaining complete rows, the window rows kept back included
+  uint16_t heldRows = pos / rowBytes;
+  rows.output(heldRows);
+  return rowsOut + heldRows;
+}
+
 ///////////////////////////////////////////////
 // Direct Streaming Context
 ///////////////////////////////////////////////
@@ -282,8 +684,9 @@ struct DirectStreamContext
 
 static DirectStreamContext g_directCtx = {nullptr, 0, 0, 0, 0, 0, 0, 0, false};
 
-// Flush completed rows from buffer to display
-static void flushCompletedRows()
+// Flush completed rows from buffer to display.
+// keepLastRow: the last row is still needed (source of a Z4 row repeat), it moves to the front unflushed.
+static void flushCompletedRows(bool keepLastRow = false)
 {
   if (!g_directCtx.initialized || !g_directCtx.buffer)
     return;
@@ -293,21 +696,30 @@ static void flushCompletedRows()
   if (currentRowPixels == 0 && g_directCtx.bufferRowIndex == 0)
     return; // Nothing to flush
 
-  uint16_t rowsToFlush = g_directCtx.bufferRowIndex + 1;
+  uint16_t rowsInBuffer = g_directCtx.bufferRowIndex + 1;
+  uint16_t rowsToFlush = keepLastRow ? rowsInBuffer - 1 : rowsInBuffer;
 
   // Get buffer data
   const uint8_t *blackData = g_directCtx.buffer->getRowData(0);
   const uint8_t *colorData = g_directCtx.buffer->getColorRowData(0);
 
   // Write rows to display
-  Display::writeRowsDirect(g_directCtx.firstRowInBuffer, rowsToFlush, blackData, colorData);
+  if (rowsToFlush > 0)
+    Display::writeRowsDirect(g_directCtx.firstRowInBuffer, rowsToFlush, blackData, colorData);
 
   Logger::log<Logger::Level::DEBUG, Logger::Topic::STREAM>("Flushed {} rows starting at y={}\n", rowsToFlush,
                                                            g_directCtx.firstRowInBuffer);
 
-  // Reset buffer for next batch — only reset rows that were actually flushed,
-  // rows beyond rowsToFlush were never written in this batch and are already clean.
-  for (uint16_t i = 0; i < rowsToFlush; i++)
+  uint16_t firstReset = 0;
+  if (keepLastRow)
+  {
+    g_directCtx.buffer->copyRow(rowsToFlush, 0);
+    firstReset = 1;
+  }
+
+  // Reset buffer for next batch — only reset rows that were actually written,
+  // rows beyond them were never written in this batch and are already clean.
+  for (uint16_t i = firstReset; i < rowsInBuffer; i++)
   {
     g_directCtx.buffer->resetRow(i);
   }
@@ -316,8 +728,8 @@ static void flushCompletedRows()
   g_directCtx.bufferRowIndex = 0;
 }
 
-// Write a single pixel in direct streaming mode
-static void directStreamPixel(uint16_t x, uint16_t y, uint16_t color)
+// Write a single pixel in direct streaming mode, code from PixelPacker::NATIVE_PALETTE
+static void directStreamPixel(uint16_t x, uint16_t y, uint8_t code)
 {
   if (!g_directCtx.initialized || !g_directCtx.buffer)
     return;
@@ -342,20 +754,17 @@ static void directStreamPixel(uint16_t x, uint16_t y, uint16_t color)
   }
 
   // Write pixel to buffer
-  g_directCtx.buffer->setPixel(g_directCtx.bufferRowIndex, x, color);
+  g_directCtx.buffer->setNativePixel(g_directCtx.bufferRowIndex, x, code);
   g_directCtx.pixelsProcessed++;
 }
 
-// Write a run of identical pixels in direct streaming mode.
+// Write a run of identical pixels in direct streaming mode, pattern from PixelPacker::RUN_PATTERNS.
 // Handles row boundaries and buffer flushing internally.
 // Much faster than calling directStreamPixel() per pixel for RLE formats.
-static void directStreamPixelRun(uint16_t &col, uint16_t &row, uint16_t count, uint16_t color)
+static void directStreamPixelRun(uint16_t &col, uint16_t &row, uint32_t count, uint16_t pattern,
+                                 uint32_t totalPixels)
 {
-  if (!g_directCtx.initialized || !g_directCtx.buffer || count == 0)
-    return;
-
   const uint16_t w = g_directCtx.displayWidth;
-  const uint32_t totalPixels = (uint32_t)g_directCtx.displayWidth * g_directCtx.displayHeight;
 
   while (count > 0 && g_directCtx.pixelsProcessed < totalPixels)
   {
@@ -388,7 +797,7 @@ static void directStreamPixelRun(uint16_t &col, uint16_t &row, uint16_t count, u
       break;
 
     // Bulk fill – replaces the per-pixel inner loop
-    g_directCtx.buffer->fillPixelRun(g_directCtx.bufferRowIndex, col, pixelsToWrite, color);
+    g_directCtx.buffer->fillNativeRun(g_directCtx.bufferRowIndex, col, pixelsToWrite, pattern);
     g_directCtx.pixelsProcessed += pixelsToWrite;
     count -= pixelsToWrite;
     col += pixelsToWrite;
@@ -401,6 +810,31 @@ static void directStreamPixelRun(uint16_t &col, uint16_t &row, uint16_t count, u
   }
 }
 
+// Repeat the last written row count times, a memcpy of the packed row inside the row buffer.
+// Only at a row start (col 0) right after row - 1 was written.
+static void directStreamRepeatRows(uint16_t &row, uint32_t count)
+{
+  while (count > 0 && row < g_directCtx.displayHeight)
+  {
+    uint16_t srcIndex = g_directCtx.bufferRowIndex;
+    if (srcIndex + 1 >= g_directCtx.bufferRowCount)
+    {
+      // Buffer full: flush all but the source row, which becomes row 0 of the next batch
+      flushCompletedRows(true);
+      g_directCtx.firstRowInBuffer = row - 1;
+      srcIndex = 0;
+    }
+
+    g_directCtx.buffer->copyRow(srcIndex, srcIndex + 1);
+    g_directCtx.bufferRowIndex = srcIndex + 1;
+    g_directCtx.currentRow = row;
+    g_directCtx.pixelsProcessed += g_directCtx.displayWidth;
+
+    row++;
+    count--;
+  }
+}
+
 // Initialize direct streaming context
 static bool initDirectStreamContext()
 {
@@ -453,74 +887,82 @@ static void finalizeDirectStream()
 // PNG Image Processing
 ///////////////////////////////////////////////
 
-// Convert RGBA to display color (unified color mapping for all image formats)
-static uint16_t rgbaToDisplayColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+// Quantize RGBA to a stream palette index, same indices as the Z formats (see mapColorValue):
+// 0 white, 1 black, 2/3 second/third color, 4-6 green/blue/orange
+static uint8_t rgbaToPaletteIndex(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
   if (a == 0)
-    return GxEPD_WHITE; // Transparent = white
+    return 0x0; // Transparent = white
 
-#if defined(TYPE_BW)
-  uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-  return (gray <= 160) ? GxEPD_BLACK : GxEPD_WHITE;
-
-#elif defined(TYPE_3C)
+#if defined(TYPE_3C)
   if (r >= 128 && r > (g + 80) && r > (b + 80))
-    return GxEPD_RED;
+    return 0x2; // Red
   uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-  return (gray <= 160) ? GxEPD_BLACK : GxEPD_WHITE;
+  return (gray <= 160) ? 0x1 : 0x0;
 
 #elif defined(TYPE_4C)
   if (r > 128 && g > 128 && b < 80)
-    return GxEPD_YELLOW;
+    return 0x3; // Yellow
   if (r > 128 && r > (g + 80) && r > (b + 80))
-    return GxEPD_RED;
+    return 0x2; // Red
   uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-  return (gray <= 160) ? GxEPD_BLACK : GxEPD_WHITE;
+  return (gray <= 160) ? 0x1 : 0x0;
 
 #elif defined(TYPE_7C)
   if (r > 200 && g > 80 && g < 180 && b < 80)
-    return GxEPD_ORANGE;
+    return 0x6; // Orange
   if (r > 128 && r > (g + 80) && r > (b + 80))
-    return GxEPD_RED;
+    return 0x2; // Red
   if (r > 128 && g > 128 && b < 80)
-    return GxEPD_YELLOW;
+    return 0x3; // Yellow
   if (g > 128 && g > (r + 80) && g > (b + 80))
-    return GxEPD_GREEN;
+    return 0x4; // Green
   if (b > 128 && b > (r + 80) && b > (g + 80))
-    return GxEPD_BLUE;
+    return 0x5; // Blue
   uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-  return (gray <= 160) ? GxEPD_BLACK : GxEPD_WHITE;
+  return (gray <= 160) ? 0x1 : 0x0;
 
 #elif defined(TYPE_GRAYSCALE)
   uint8_t gray = (r + g + b) / 3;
   if (gray > 160)
-    return GxEPD_WHITE;
+    return 0x0;
   if (gray > 101)
-    return GxEPD_LIGHTGREY;
+    return 0x2; // Light grey
   if (gray > 32)
-    return GxEPD_DARKGREY;
-  return GxEPD_BLACK;
+    return 0x3; // Dark grey
+  return 0x1;
+
+#else
+  uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
+  return (gray <= 160) ? 0x1 : 0x0;
+#endif
+}
+
+// Convert RGBA to display color (unified color mapping for all image formats), used by the GFX/paged path
+static uint16_t rgbaToDisplayColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+#if defined(TYPE_8G)
+  if (a == 0)
+    return GxEPD_WHITE; // Transparent = white
 
-#elif defined(TYPE_8G)
   // 8-level grayscale: produce RGB565 gray value
   // drawPixel → colorToEpdiy will convert to full 16-level 4bpp grayscale
-  {
-    uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-    uint8_t r5 = gray >> 3;
-    uint8_t g6 = gray >> 2;
-    uint8_t b5 = gray >> 3;
-    return (uint16_t)(r5 << 11) | (g6 << 5) | b5;
-  }
-
-#else
   uint8_t gray = (r * 77 + g * 150 + b * 29) >> 8;
-  return (gray <= 160) ? GxEPD_BLACK : GxEPD_WHITE;
+  uint8_t r5 = gray >> 3;
+  uint8_t g6 = gray >> 2;
+  uint8_t b5 = gray >> 3;
+  return (uint16_t)(r5 << 11) | (g6 << 5) | b5;
+#else
+  return mapColorValue(rgbaToPaletteIndex(r, g, b, a), getSecondColor(), getThirdColor());
 #endif
 }
 
 // Callback: Draw pixel from PNG decoder
 static void pngleOnDraw(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t rgba[4])
 {
+  // PNG holds only a row range of the image when the server honored the page's row request
+  y += *static_cast<const uint16_t *>(pngle_get_user_data(pngle));
+
   if ((x >= Display::getWidth()) || (y >= Display::getHeight()))
   {
     Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("PNG pixel out of bounds: ({}, {})\n", x, y);
@@ -536,7 +978,7 @@ static void pngleOnDraw(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint
     yield();
 }
 
-static bool processPNG(HttpClient &http, uint32_t startTime, uint8_t *buffer, uint16_t bufferSize)
+static bool processPNG(HttpClient &http, uint32_t startTime, uint16_t firstRow, uint8_t *buffer, uint16_t bufferSize)
 {
   Logger::log<Logger::Topic::IMAGE>("Got format PNG, processing\n");
 
@@ -548,8 +990,9 @@ static bool processPNG(HttpClient &http, uint32_t startTime, uint8_t *buffer, ui
     return false;
   }
 
-  // Set draw callback
+  // Set draw callback, first image row is passed as user data
   pngle_set_draw_callback(pngle, pngleOnDraw);
+  pngle_set_user_data(pngle, &firstRow);
 
   // Reconstruct PNG signature: we already read first 2 bytes (0x89 0x50) for format detection
   // PNG signature is 8 bytes: 0x89 0x50 0x4E 0x47 0x0D 0x0A 0x1A 0x0A
@@ -581,7 +1024,7 @@ static bool processPNG(HttpClient &http, uint32_t startTime, uint8_t *buffer, ui
 
   while (http.isConnected() || http.available())
   {
-    uint32_t chunkSize = http.readBytes(buffer, bufferSize);
+    uint32_t chunkSize = http.readInto(buffer, bufferSize);
     if (chunkSize == 0)
       break;
 
@@ -626,15 +1069,16 @@ static void pngleOnDrawDirect(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w
   if (x >= g_directCtx.displayWidth || y >= g_directCtx.displayHeight)
     return;
 
-  uint16_t color = rgbaToDisplayColor(rgba[0], rgba[1], rgba[2], rgba[3]);
-  directStreamPixel(x, y, color);
+  uint8_t index = rgbaToPaletteIndex(rgba[0], rgba[1], rgba[2], rgba[3]);
+  directStreamPixel(x, y, PixelPacker::NATIVE_PALETTE[index]);
 
   // Yield periodically
   if (g_directCtx.pixelsProcessed % 1000 == 0)
     yield();
 }
 
-static bool processPNGDirect(HttpClient &http, uint32_t startTime, uint8_t *buffer, uint16_t bufferSize)
+static bool processPNGDirect(HttpClient &http, NetworkReader &reader, uint32_t startTime, uint8_t *buffer,
+                             uint16_t bufferSize)
 {
   Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("PNG Processing (direct streaming mode)\n");
 
@@ -677,9 +1121,12 @@ static bool processPNGDirect(HttpClient &http, uint32_t startTime, uint8_t *buff
   uint32_t bytes_read = 8;
   bool success = true;
 
-  while (http.isConnected() || http.available())
+  // Rest of the body comes through the reader task while pngle decodes
+  reader.start();
+
+  while (reader.isConnected() || reader.available())
   {
-    uint32_t chunkSize = http.readBytes(buffer, bufferSize);
+    uint32_t chunkSize = reader.readInto(buffer, bufferSize);
     if (chunkSize == 0)
       break;
 
@@ -731,11 +1178,41 @@ static bool processPNGDirect(HttpClient &http, uint32_t startTime, uint8_t *buff
   return success;
 }
 
-static bool processRLEDirect(HttpClient &http, uint32_t startTime, ImageFormat format, uint8_t *buffer,
-                             uint16_t bufferSize)
+// Decode one Z-format run record, the format is resolved at compile time
+template <ImageFormat Format>
+static inline void decodeRunRecord(const uint8_t *record, uint8_t &pixelColor, uint8_t &count)
+{
+  if (Format == ImageFormat::Z1)
+  {
+    // Z1: 1 byte color + 1 byte count
+    pixelColor = record[0];
+    count = record[1];
+  }
+  else if (Format == ImageFormat::Z2)
+  {
+    // Z2: 2-bit color + 6-bit count
+    count = record[0] & 0b00111111;
+    pixelColor = (record[0] & 0b11000000) >> 6;
+  }
+  else
+  {
+    // Z3: 3-bit color + 5-bit count
+    count = record[0] & 0b00011111;
+    pixelColor = (record[0] & 0b11100000) >> 5;
+  }
+}
+
+// One instance per Z format, dispatched once after the header scan. Run colors come straight from
+// PixelPacker::RUN_PATTERNS of the compiled display format, so a run costs no format or color switch.
+template <ImageFormat Format>
+static bool processRLEDirect(NetworkReader &reader, uint32_t startTime, uint8_t *buffer, uint16_t bufferSize)
 {
+  static_assert(Format == ImageFormat::Z1 || Format == ImageFormat::Z2 || Format == ImageFormat::Z3,
+                "Not a run-length format");
+  constexpr uint32_t RECORD_SIZE = (Format == ImageFormat::Z1) ? 2 : 1;
+
   Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("Processing {} (direct streaming mode)\n",
-                                                         formatToString(format));
+                                                         formatToString(Format));
 
   if (!initDirectStreamContext())
   {
@@ -748,23 +1225,39 @@ static bool processRLEDirect(HttpClient &http, uint32_t startTime, ImageFormat f
   uint16_t h = g_directCtx.displayHeight;
   uint32_t totalPixels = w * h;
 
-  uint16_t color2 = getSecondColor();
-  uint16_t color3 = getThirdColor();
-
   uint16_t row = 0;
   uint16_t col = 0;
 
   uint32_t bufferPos = 0;
   uint32_t bufferAvailable = 0;
-  bool bufferEmpty = true;
+  uint8_t resumeAttempts = 0;
+
+  // Receive on the reader task while runs are decoded and rows written here
+  reader.start();
 
   while (g_directCtx.pixelsProcessed < totalPixels)
   {
-    // Refill buffer if needed
-    if (bufferEmpty || bufferPos >= bufferAvailable)
+    // Refill buffer if needed (Z1 records are 2 bytes and may straddle reads)
+    if (bufferPos + RECORD_SIZE > bufferAvailable)
     {
-      if (!http.isConnected() && !http.available())
+      // Carry over a dangling half of a Z1 record
+      uint32_t leftover = bufferAvailable - bufferPos;
+      if (leftover > 0)
+        buffer[0] = buffer[bufferPos];
+
+      uint32_t bytesRead = 0;
+      if (reader.isConnected() || reader.available())
+        bytesRead = reader.readInto(buffer + leftover, bufferSize - leftover);
+
+      if (bytesRead == 0)
       {
+        // Dangling half record is requested again together with the rest
+        if (resumeImageDownload(reader, reader.getBodyOffset() - leftover, resumeAttempts))
+        {
+          bufferPos = bufferAvailable = 0;
+          continue;
+        }
+
         if (g_directCtx.pixelsProcessed >= (totalPixels * 95 / 100))
         {
           Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>(
@@ -777,49 +1270,23 @@ static bool processRLEDirect(HttpClient &http, uint32_t startTime, ImageFormat f
         return false;
       }
 
-      uint32_t bytesRead = http.readBytes(buffer, bufferSize);
-      if (bytesRead == 0)
-        break;
-
       bufferPos = 0;
-      bufferEmpty = false;
       bytes_read += bytesRead;
-      bufferAvailable = bytesRead;
+      bufferAvailable = leftover + bytesRead;
+      continue;
     }
 
     uint8_t pixelColor, count;
+    decodeRunRecord<Format>(buffer + bufferPos, pixelColor, count);
+    bufferPos += RECORD_SIZE;
 
-    if (format == ImageFormat::Z1)
-    {
-      if (bufferPos + 1 >= bufferAvailable)
-      {
-        bufferEmpty = true;
-        continue;
-      }
-      pixelColor = buffer[bufferPos++];
-      count = buffer[bufferPos++];
-    }
-    else
-    {
-      uint8_t compressed = buffer[bufferPos++];
-
-      if (format == ImageFormat::Z2)
-      {
-        count = compressed & 0b00111111;
-        pixelColor = (compressed & 0b11000000) >> 6;
-      }
-      else // Z3
-      {
-        count = compressed & 0b00011111;
-        pixelColor = (compressed & 0b11100000) >> 5;
-      }
-    }
-
-    uint16_t color = mapColorValue(pixelColor, color2, color3);
+    // Z2/Z3 indices always fit the palette, out of range Z1 colors are white like in mapColorValue
+    if (Format == ImageFormat::Z1 && pixelColor >= PixelPacker::PALETTE_SIZE)
+      pixelColor = 0;
 
     // Write the entire RLE run in one bulk operation instead of pixel-by-pixel.
     // directStreamPixelRun handles row boundaries and buffer flushes internally.
-    directStreamPixelRun(col, row, (uint16_t)count, color);
+    directStreamPixelRun(col, row, count, PixelPacker::RUN_PATTERNS[pixelColor], totalPixels);
 
     if (g_directCtx.pixelsProcessed % 10000 == 0)
       yield();
@@ -834,40 +1301,379 @@ static bool processRLEDirect(HttpClient &http, uint32_t startTime, ImageFormat f
   return (g_directCtx.pixelsProcessed >= totalPixels * 95 / 100);
 }
 
-#endif // STREAMING_ENABLED && STREAMING_DIRECT_MODE
-
-///////////////////////////////////////////////
-// Unified RLE Format Processing
-///////////////////////////////////////////////
-
-static bool processRLE(HttpClient &http, uint32_t startTime, ImageFormat format, uint8_t *buffer, uint16_t bufferSize)
+static bool processZ4Direct(NetworkReader &reader, uint32_t startTime, uint8_t *buffer, uint16_t bufferSize)
 {
-  Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z Got format {}, processing\n", formatToString(format));
+  Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("Processing Z4 (direct streaming mode)\n");
+
+  if (!initDirectStreamContext())
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Z4 Failed to init direct stream context\n");
+    return false;
+  }
 
   uint32_t bytes_read = 2; // Already read header
-  uint16_t w = Display::getResolutionX();
-  uint16_t h = Display::getResolutionY();
+  uint16_t w = g_directCtx.displayWidth;
+  uint16_t h = g_directCtx.displayHeight;
   uint32_t totalPixels = w * h;
 
-  uint16_t color2 = getSecondColor();
-  uint16_t color3 = getThirdColor();
-
   uint16_t row = 0;
   uint16_t col = 0;
-  uint32_t pixelsProcessed = 0;
 
-  // Use passed buffer for efficient reading
   uint32_t bufferPos = 0;
   uint32_t bufferAvailable = 0;
-  bool bufferEmpty = true;
+  uint8_t resumeAttempts = 0;
+  uint32_t records = 0;
 
-  while (pixelsProcessed < totalPixels)
+  // Receive on the reader task while records are decoded and rows written here
+  reader.start();
+
+  while (g_directCtx.pixelsProcessed < totalPixels)
   {
-    // Refill buffer if needed
-    if (bufferEmpty || bufferPos >= bufferAvailable)
+    Z4Record record;
+    uint32_t recordSize =
+      (bufferPos < bufferAvailable) ? decodeZ4Record(buffer + bufferPos, bufferAvailable - bufferPos, record) : 0;
+
+    if (recordSize == 0)
     {
-      if (!http.isConnected() && !http.available())
+      // Carry over the start of a record that straddles reads
+      uint32_t leftover = bufferAvailable - bufferPos;
+      memmove(buffer, buffer + bufferPos, leftover);
+
+      uint32_t bytesRead = 0;
+      if (reader.isConnected() || reader.available())
+        bytesRead = reader.readInto(buffer + leftover, bufferSize - leftover);
+
+      if (bytesRead == 0)
+      {
+        // Partial record is requested again together with the rest
+        if (resumeImageDownload(reader, reader.getBodyOffset() - leftover, resumeAttempts))
+        {
+          bufferPos = bufferAvailable = 0;
+          continue;
+        }
+
+        if (g_directCtx.pixelsProcessed >= (totalPixels * 95 / 100))
+        {
+          Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("Z4 Image is 95%+ complete, accepting as valid\n");
+          break;
+        }
+        Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Z4 Incomplete: {}/{} pixels\n",
+                                                                g_directCtx.pixelsProcessed, totalPixels);
+        finalizeDirectStream();
+        return false;
+      }
+
+      bufferPos = 0;
+      bytes_read += bytesRead;
+      bufferAvailable = leftover + bytesRead;
+      continue;
+    }
+
+    bufferPos += recordSize;
+
+    if (record.op == Z4Op::Run)
+    {
+      directStreamPixelRun(col, row, record.count, PixelPacker::RUN_PATTERNS[record.color], totalPixels);
+    }
+    else if (record.op == Z4Op::RepeatRows && col == 0 && row > 0 && g_directCtx.currentRow == row - 1)
+    {
+      directStreamRepeatRows(row, record.count);
+    }
+    else
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Z4 Invalid record 0x{} at row {}, col {}\n",
+                                                              String(buffer[bufferPos - recordSize], HEX).c_str(),
+                                                              row, col);
+      finalizeDirectStream();
+      return false;
+    }
+
+    if (++records % 4096 == 0)
+      yield();
+  }
+
+  finalizeDirectStream();
+
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Bytes read {}, pixels processed {}\n", bytes_read,
+                                                        g_directCtx.pixelsProcessed);
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return (g_directCtx.pixelsProcessed >= totalPixels * 95 / 100);
+}
+
+// Rows already in the native layout are received straight into the band memory and written out band by band,
+// no decoding and no intermediate copy
+static bool processPackedDirect(HttpClient &http, NetworkReader &reader, uint32_t startTime)
+{
+  Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("Processing ZP (direct streaming mode)\n");
+
+  if (!initDirectStreamContext())
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZP Failed to init direct stream context\n");
+    return false;
+  }
+
+  if (!readPackedHeader(http, g_directCtx.displayWidth))
+  {
+    finalizeDirectStream();
+    return false;
+  }
+
+  StreamingHandler::RowStreamBuffer *band = g_directCtx.buffer;
+  const uint32_t rowSize = band->getRowSize();
+  const uint32_t planes = band->hasColorBuffer() ? 2 : 1;
+  const uint16_t w = g_directCtx.displayWidth;
+  const uint16_t h = g_directCtx.displayHeight;
+  const uint32_t totalPixels = (uint32_t)w * h;
+
+  uint32_t bytes_read = 2 + PACKED_HEADER_SIZE;
+  uint8_t resumeAttempts = 0;
+  uint16_t row = 0;
+  bool truncated = false;
+
+  // Receive on the reader task while the previous band goes out to the display
+  reader.start();
+
+  while (row < h && !truncated)
+  {
+    uint16_t bandRows = (h - row < g_directCtx.bufferRowCount) ? (h - row) : g_directCtx.bufferRowCount;
+    uint32_t bandBytes = (uint32_t)bandRows * rowSize * planes;
+    uint32_t pos = 0;
+
+    while (pos < bandBytes)
+    {
+      // Single plane: the band is one contiguous block. 3C: planes alternate per row in the stream.
+      uint8_t *target;
+      uint32_t space;
+      if (planes == 1)
+      {
+        target = band->getRowDataMutable(0) + pos;
+        space = bandBytes - pos;
+      }
+      else
+      {
+        uint32_t rowIndex = pos / (2 * rowSize);
+        uint32_t inRow = pos % (2 * rowSize);
+        target = (inRow < rowSize) ? band->getRowDataMutable(rowIndex) : band->getColorRowDataMutable(rowIndex);
+        target += inRow % rowSize;
+        space = rowSize - inRow % rowSize;
+      }
+
+      uint32_t bytesRead = 0;
+      if (reader.isConnected() || reader.available())
+        bytesRead = reader.readInto(target, space);
+
+      if (bytesRead == 0)
+      {
+        if (resumeImageDownload(reader, reader.getBodyOffset(), resumeAttempts))
+          continue;
+
+        // Keep the complete rows of this band
+        bandRows = pos / (rowSize * planes);
+        truncated = true;
+        break;
+      }
+
+      pos += bytesRead;
+      bytes_read += bytesRead;
+    }
+
+    if (bandRows > 0)
+    {
+      Display::writeRowsDirect(row, bandRows, band->getRowData(0), band->getColorRowData(0));
+      row += bandRows;
+
+      // Nothing left in the band for finalizeDirectStream to flush
+      g_directCtx.firstRowInBuffer = row;
+      g_directCtx.currentRow = row - 1;
+      g_directCtx.pixelsProcessed = (uint32_t)row * w;
+    }
+
+    yield();
+  }
+
+  if (truncated)
+  {
+    if (g_directCtx.pixelsProcessed >= (totalPixels * 95 / 100))
+    {
+      Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("ZP Image is 95%+ complete, accepting as valid\n");
+    }
+    else
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZP Incomplete: {}/{} rows\n", row, h);
+      finalizeDirectStream();
+      return false;
+    }
+  }
+
+  finalizeDirectStream();
+
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Bytes read {}, pixels processed {}\n", bytes_read,
+                                                        g_directCtx.pixelsProcessed);
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return true;
+}
+
+// Decoded ZL rows held in the band itself, the rows kept back after each write are the back-reference window
+struct BandRows
+{
+  StreamingHandler::RowStreamBuffer *band;
+  uint32_t rowSize;
+  uint32_t planes;
+  uint16_t nextRow;
+
+  uint32_t rowBytes() const { return rowSize * planes; }
+  uint16_t capacity() const { return g_directCtx.bufferRowCount; }
+
+  // Single plane: the band is one contiguous block. 3C: planes alternate per row in the stream.
+  uint8_t *at(uint32_t pos, uint32_t &contiguous)
+  {
+    if (planes == 1)
+    {
+      contiguous = (uint32_t)capacity() * rowSize - pos;
+      return band->getRowDataMutable(0) + pos;
+    }
+
+    uint32_t rowIndex = pos / (2 * rowSize);
+    uint32_t inRow = pos % (2 * rowSize);
+    uint8_t *target = (inRow < rowSize) ? band->getRowDataMutable(rowIndex) : band->getColorRowDataMutable(rowIndex);
+    contiguous = rowSize - inRow % rowSize;
+    return target + inRow % rowSize;
+  }
+
+  void output(uint16_t count)
+  {
+    if (count == 0)
+      return;
+
+    Display::writeRowsDirect(nextRow, count, band->getRowData(0), band->getColorRowData(0));
+    nextRow += count;
+
+    // Nothing left in the band for finalizeDirectStream to flush
+    g_directCtx.firstRowInBuffer = nextRow;
+    g_directCtx.currentRow = nextRow - 1;
+    g_directCtx.pixelsProcessed = (uint32_t)nextRow * g_directCtx.displayWidth;
+    yield();
+  }
+
+  void moveToFront(uint16_t first, uint16_t count)
+  {
+    for (uint16_t i = 0; i < count; i++)
+      band->copyRow(first + i, i);
+  }
+};
+
+// Back-references reach only rows still in the band, so ZL needs no memory beyond it
+static bool processZLDirect(HttpClient &http, NetworkReader &reader, uint32_t startTime, uint8_t *buffer,
+                            uint16_t bufferSize)
+{
+  Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("Processing ZL (direct streaming mode)\n");
+
+  if (!initDirectStreamContext())
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Failed to init direct stream context\n");
+    return false;
+  }
+
+  uint16_t windowRows;
+  if (!readPackedHeader(http, g_directCtx.displayWidth) || !readWindowRows(http, windowRows))
+  {
+    finalizeDirectStream();
+    return false;
+  }
+
+  if (windowRows >= g_directCtx.bufferRowCount)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Window of {} rows does not fit the {} row band\n",
+                                                            windowRows, g_directCtx.bufferRowCount);
+    finalizeDirectStream();
+    return false;
+  }
+
+  StreamingHandler::RowStreamBuffer *band = g_directCtx.buffer;
+  BandRows rows = {band, (uint32_t)band->getRowSize(), band->hasColorBuffer() ? 2u : 1u, 0};
+  const uint16_t h = g_directCtx.displayHeight;
+  uint32_t bytes_read = 2 + PACKED_HEADER_SIZE + 2;
+  bool valid;
+
+  // Receive on the reader task while records are decoded and bands written here
+  reader.start();
+
+  uint16_t rowsWritten = decodeZLRows(reader, rows, h, windowRows, buffer, bufferSize, bytes_read, valid);
+
+  finalizeDirectStream();
+
+  if (!valid)
+    return false;
+
+  if (rowsWritten < h)
+  {
+    if ((uint32_t)rowsWritten * 100 < (uint32_t)h * 95)
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Incomplete: {}/{} rows\n", rowsWritten, h);
+      return false;
+    }
+    Logger::log<Logger::Level::INFO, Logger::Topic::IMAGE>("ZL Image is 95%+ complete, accepting as valid\n");
+  }
+
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Bytes read {}, pixels processed {}\n", bytes_read,
+                                                        g_directCtx.pixelsProcessed);
+  Logger::log<Logger::Level::INFO, Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return true;
+}
+
+#endif // STREAMING_ENABLED && STREAMING_DIRECT_MODE
+
+///////////////////////////////////////////////
+// Unified RLE Format Processing
+///////////////////////////////////////////////
+
+static bool processRLE(HttpClient &http, uint32_t startTime, ImageFormat format, uint16_t firstRow, uint16_t rowCount,
+                       uint8_t *buffer, uint16_t bufferSize)
+{
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z Got format {}, processing\n", formatToString(format));
+
+  uint32_t bytes_read = 2; // Already read header
+  uint16_t w = Display::getResolutionX();
+  uint32_t totalPixels = (uint32_t)w * rowCount;
+
+  uint16_t color2 = getSecondColor();
+  uint16_t color3 = getThirdColor();
+
+  uint16_t row = firstRow;
+  uint16_t col = 0;
+  uint32_t pixelsProcessed = 0;
+
+  // Use passed buffer for efficient reading
+  uint32_t bufferPos = 0;
+  uint32_t bufferAvailable = 0;
+  uint8_t resumeAttempts = 0;
+
+  while (pixelsProcessed < totalPixels)
+  {
+    // Refill buffer if needed (Z1 records are 2 bytes and may straddle reads)
+    if (bufferPos >= bufferAvailable || (format == ImageFormat::Z1 && bufferPos + 1 >= bufferAvailable))
+    {
+      // Carry over a dangling half of a Z1 record
+      uint32_t leftover = bufferAvailable - bufferPos;
+      if (leftover > 0)
+        buffer[0] = buffer[bufferPos];
+
+      uint32_t bytesRead = 0;
+      if (http.isConnected() || http.available())
+        bytesRead = http.readInto(buffer + leftover, bufferSize - leftover);
+
+      if (bytesRead == 0)
       {
+        // Dangling half record is requested again together with the rest
+        if (resumeImageDownload(http, http.getBodyOffset() - leftover, resumeAttempts))
+        {
+          bufferPos = bufferAvailable = 0;
+          continue;
+        }
+
         Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>(
           "Z Incomplete image received. Pixels processed: {}/{}\n", pixelsProcessed, totalPixels);
 
@@ -880,18 +1686,10 @@ static bool processRLE(HttpClient &http, uint32_t startTime, ImageFormat format,
         return false;
       }
 
-      uint32_t bytesRead = http.readBytes(buffer, bufferSize);
-      if (bytesRead == 0)
-      {
-        Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z No more data available. Pixels processed: {}/{}\n",
-                                                                pixelsProcessed, totalPixels);
-        break;
-      }
-
       bufferPos = 0;
-      bufferEmpty = false;
       bytes_read += bytesRead;
-      bufferAvailable = bytesRead;
+      bufferAvailable = leftover + bytesRead;
+      continue;
     }
 
     uint8_t pixelColor, count;
@@ -900,12 +1698,6 @@ static bool processRLE(HttpClient &http, uint32_t startTime, ImageFormat format,
     if (format == ImageFormat::Z1)
     {
       // Z1: 1 byte color + 1 byte count
-      if (bufferPos + 1 >= bufferAvailable)
-      {
-        // Need more data for Z1 (2 bytes)
-        bufferEmpty = true;
-        continue;
-      }
       pixelColor = buffer[bufferPos++];
       count = buffer[bufferPos++];
     }
@@ -954,6 +1746,326 @@ static bool processRLE(HttpClient &http, uint32_t startTime, ImageFormat format,
   return (pixelsProcessed == totalPixels);
 }
 
+static bool processZ4(HttpClient &http, uint32_t startTime, uint16_t firstRow, uint16_t rowCount, uint8_t *buffer,
+                      uint16_t bufferSize)
+{
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z Got format Z4, processing\n");
+
+  uint32_t bytes_read = 2; // Already read header
+  uint16_t w = Display::getResolutionX();
+  uint32_t totalPixels = (uint32_t)w * rowCount;
+
+  // Palette indices of the row being drawn, the source of row repeats
+  uint8_t *line = new (std::nothrow) uint8_t[w];
+  if (!line)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Z4 Failed to allocate line buffer\n");
+    return false;
+  }
+
+  uint16_t palette[PixelPacker::PALETTE_SIZE];
+  for (uint8_t i = 0; i < PixelPacker::PALETTE_SIZE; i++)
+    palette[i] = mapColorValue(i, getSecondColor(), getThirdColor());
+
+  uint16_t row = firstRow;
+  uint16_t col = 0;
+  uint32_t pixelsProcessed = 0;
+
+  uint32_t bufferPos = 0;
+  uint32_t bufferAvailable = 0;
+  uint8_t resumeAttempts = 0;
+  uint32_t records = 0;
+  bool success = true;
+
+  while (pixelsProcessed < totalPixels)
+  {
+    Z4Record record;
+    uint32_t recordSize =
+      (bufferPos < bufferAvailable) ? decodeZ4Record(buffer + bufferPos, bufferAvailable - bufferPos, record) : 0;
+
+    if (recordSize == 0)
+    {
+      // Carry over the start of a record that straddles reads
+      uint32_t leftover = bufferAvailable - bufferPos;
+      memmove(buffer, buffer + bufferPos, leftover);
+
+      uint32_t bytesRead = 0;
+      if (http.isConnected() || http.available())
+        bytesRead = http.readInto(buffer + leftover, bufferSize - leftover);
+
+      if (bytesRead == 0)
+      {
+        // Partial record is requested again together with the rest
+        if (resumeImageDownload(http, http.getBodyOffset() - leftover, resumeAttempts))
+        {
+          bufferPos = bufferAvailable = 0;
+          continue;
+        }
+
+        Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>(
+          "Z4 Incomplete image received. Pixels processed: {}/{}\n", pixelsProcessed, totalPixels);
+
+        // If we're close to complete (95%+), consider it a success
+        success = (pixelsProcessed >= (totalPixels * 95 / 100));
+        if (success)
+          Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>("Z4 Image is 95%+ complete, accepting as valid\n");
+        break;
+      }
+
+      bufferPos = 0;
+      bytes_read += bytesRead;
+      bufferAvailable = leftover + bytesRead;
+      continue;
+    }
+
+    bufferPos += recordSize;
+
+    if (record.op == Z4Op::Run)
+    {
+      uint16_t color = palette[record.color];
+      for (uint32_t i = 0; i < record.count && pixelsProcessed < totalPixels; i++)
+      {
+        line[col] = record.color;
+        Display::drawPixel(col, row, color);
+        pixelsProcessed++;
+
+        if (++col >= w)
+        {
+          col = 0;
+          row++;
+        }
+      }
+    }
+    else if (record.op == Z4Op::RepeatRows && col == 0 && row > firstRow)
+    {
+      // Line still holds the previous row, nothing has been drawn into this one yet
+      for (uint32_t i = 0; i < record.count && pixelsProcessed < totalPixels; i++)
+      {
+        for (uint16_t x = 0; x < w; x++)
+          Display::drawPixel(x, row, palette[line[x]]);
+        pixelsProcessed += w;
+        row++;
+      }
+    }
+    else
+    {
+      Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Z4 Invalid record 0x{} at row {}, col {}\n",
+                                                              String(buffer[bufferPos - recordSize], HEX).c_str(),
+                                                              row, col);
+      success = false;
+      break;
+    }
+
+    if (++records % 4096 == 0)
+      yield();
+  }
+
+  delete[] line;
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Bytes read {}\n", bytes_read);
+  if (success)
+    Logger::log<Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return success;
+}
+
+// Native code -> GFX color, the lowest palette index wins where codes repeat
+static void buildNativeColors(uint16_t *colors)
+{
+  for (uint8_t code = 0; code < (1 << 4); code++)
+    colors[code] = GxEPD_WHITE;
+  for (int8_t i = PixelPacker::PALETTE_SIZE - 1; i >= 0; i--)
+    colors[PixelPacker::NATIVE_PALETTE[i]] = mapColorValue(i, getSecondColor(), getThirdColor());
+}
+
+// Draw one row in the ZP stream layout (3C: black plane row, then color plane row)
+static void drawPackedRow(const uint8_t *rowData, uint32_t rowSize, uint16_t y, const uint16_t *colors)
+{
+  const uint16_t w = Display::getResolutionX();
+  for (uint16_t x = 0; x < w; x++)
+  {
+#ifdef TYPE_3C
+    uint8_t code =
+      PixelPacker::unpackNativePixel<1>(rowData, x) | (PixelPacker::unpackNativePixel<1>(rowData + rowSize, x) << 1);
+#else
+    (void)rowSize;
+    uint8_t code = PixelPacker::unpackNativePixel<PixelPacker::NATIVE_BITS_PER_PIXEL>(rowData, x);
+#endif
+    Display::drawPixel(x, y, colors[code]);
+  }
+}
+
+static bool processPacked(HttpClient &http, uint32_t startTime, uint16_t firstRow, uint16_t rowCount)
+{
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z Got format ZP, processing\n");
+
+  uint16_t w = Display::getResolutionX();
+  if (!readPackedHeader(http, w))
+    return false;
+
+  const PixelPacker::DisplayFormat format = PixelPacker::getDisplayFormat();
+  const uint32_t rowSize = PixelPacker::getRowBufferSize(w, format);
+  const uint32_t rowBytes = rowSize * ((format == PixelPacker::DisplayFormat::COLOR_3C) ? 2 : 1);
+
+  uint8_t *rowData = new (std::nothrow) uint8_t[rowBytes];
+  if (!rowData)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZP Failed to allocate row buffer\n");
+    return false;
+  }
+
+  uint16_t colors[1 << 4];
+  buildNativeColors(colors);
+
+  uint32_t bytes_read = 2 + PACKED_HEADER_SIZE;
+  uint8_t resumeAttempts = 0;
+  uint16_t rowsDrawn = 0;
+  bool success = true;
+
+  while (rowsDrawn < rowCount)
+  {
+    // Receive one full row (all planes)
+    uint32_t filled = 0;
+    while (filled < rowBytes)
+    {
+      uint32_t bytesRead = 0;
+      if (http.isConnected() || http.available())
+        bytesRead = http.readInto(rowData + filled, rowBytes - filled);
+
+      if (bytesRead == 0)
+      {
+        // Partial row is requested again
+        if (resumeImageDownload(http, http.getBodyOffset() - filled, resumeAttempts))
+        {
+          filled = 0;
+          continue;
+        }
+        break;
+      }
+
+      filled += bytesRead;
+      bytes_read += bytesRead;
+    }
+
+    if (filled < rowBytes)
+    {
+      Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>("ZP Incomplete image received. Rows: {}/{}\n",
+                                                                rowsDrawn, rowCount);
+      success = ((uint32_t)rowsDrawn * 100 >= (uint32_t)rowCount * 95);
+      break;
+    }
+
+    drawPackedRow(rowData, rowSize, firstRow + rowsDrawn, colors);
+    rowsDrawn++;
+    yield();
+  }
+
+  delete[] rowData;
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Bytes read {}\n", bytes_read);
+  if (success)
+    Logger::log<Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return success;
+}
+
+// Decoded ZL rows in a line buffer, the first window rows hold the back-reference history
+struct LineRows
+{
+  uint8_t *data;
+  uint16_t rowCapacity;
+  uint32_t rowSize;
+  uint32_t bytesPerRow;
+  uint16_t nextRow;
+  const uint16_t *colors;
+
+  uint32_t rowBytes() const { return bytesPerRow; }
+  uint16_t capacity() const { return rowCapacity; }
+
+  uint8_t *at(uint32_t pos, uint32_t &contiguous)
+  {
+    contiguous = (uint32_t)rowCapacity * bytesPerRow - pos;
+    return data + pos;
+  }
+
+  void output(uint16_t count)
+  {
+    for (uint16_t i = 0; i < count; i++)
+    {
+      drawPackedRow(data + (uint32_t)i * bytesPerRow, rowSize, nextRow++, colors);
+      yield();
+    }
+  }
+
+  void moveToFront(uint16_t first, uint16_t count)
+  {
+    memmove(data, data + (uint32_t)first * bytesPerRow, (uint32_t)count * bytesPerRow);
+  }
+};
+
+static bool processZL(HttpClient &http, uint32_t startTime, uint16_t firstRow, uint16_t rowCount, uint8_t *buffer,
+                      uint16_t bufferSize)
+{
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Z Got format ZL, processing\n");
+
+  uint16_t w = Display::getResolutionX();
+  uint16_t windowRows;
+  if (!readPackedHeader(http, w) || !readWindowRows(http, windowRows))
+    return false;
+
+  const PixelPacker::DisplayFormat format = PixelPacker::getDisplayFormat();
+  const uint32_t rowSize = PixelPacker::getRowBufferSize(w, format);
+  const uint32_t rowBytes = rowSize * ((format == PixelPacker::DisplayFormat::COLOR_3C) ? 2 : 1);
+
+  // The window comes from the stream, a window as tall as the image references nothing the rows can't
+  if (windowRows >= rowCount)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Window of {} rows for a {} row image\n", windowRows,
+                                                            rowCount);
+    return false;
+  }
+
+  // Window plus a few rows per draw batch, one row past the window is enough (never more than the image)
+  const uint8_t BATCH_ROWS = 8;
+  uint32_t batchCapacity = (uint32_t)windowRows + BATCH_ROWS;
+  uint16_t rowCapacity = (batchCapacity < rowCount) ? batchCapacity : rowCount;
+  uint8_t *rowData = new (std::nothrow) uint8_t[(uint32_t)rowCapacity * rowBytes];
+  if (!rowData)
+  {
+    rowCapacity = windowRows + 1;
+    rowData = new (std::nothrow) uint8_t[(uint32_t)rowCapacity * rowBytes];
+  }
+  if (!rowData)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("ZL Failed to allocate {} window rows\n", windowRows);
+    return false;
+  }
+
+  uint16_t colors[1 << 4];
+  buildNativeColors(colors);
+
+  LineRows rows = {rowData, rowCapacity, rowSize, rowBytes, firstRow, colors};
+  uint32_t bytes_read = 2 + PACKED_HEADER_SIZE + 2;
+  bool valid;
+  uint16_t rowsDrawn = decodeZLRows(http, rows, rowCount, windowRows, buffer, bufferSize, bytes_read, valid);
+
+  delete[] rowData;
+
+  bool success = valid && rowsDrawn == rowCount;
+  if (valid && !success)
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::IMAGE>("ZL Incomplete image received. Rows: {}/{}\n",
+                                                              rowsDrawn, rowCount);
+    success = ((uint32_t)rowsDrawn * 100 >= (uint32_t)rowCount * 95);
+  }
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Bytes read {}\n", bytes_read);
+  if (success)
+    Logger::log<Logger::Topic::HTTP>("Loaded in {} ms\n", millis() - startTime);
+
+  return success;
+}
+
 ///////////////////////////////////////////////
 // Main Image Reader
 ///////////////////////////////////////////////
@@ -998,6 +2110,12 @@ void readImageData(HttpClient &http)
 
   Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Image format header: 0x{}\n", String(header, HEX).c_str());
 
+  // Body may hold only the rows of the current page
+  uint16_t firstRow = 0;
+  uint16_t rowCount = Display::getResolutionY();
+  if (http.getRowRange(firstRow, rowCount))
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Image rows {}-{}\n", firstRow, firstRow + rowCount - 1);
+
   // Dynamic buffer for PNG/RLE processing
   // BMP handles its own buffer allocation
   const uint16_t STREAM_BUFFER_SIZE = 512;
@@ -1013,19 +2131,31 @@ void readImageData(HttpClient &http)
   switch (static_cast<ImageFormat>(header))
   {
     case ImageFormat::PNG:
-      success = processPNG(http, startTime, buffer, STREAM_BUFFER_SIZE);
+      success = processPNG(http, startTime, firstRow, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z1:
-      success = processRLE(http, startTime, ImageFormat::Z1, buffer, STREAM_BUFFER_SIZE);
+      success = processRLE(http, startTime, ImageFormat::Z1, firstRow, rowCount, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z2:
-      success = processRLE(http, startTime, ImageFormat::Z2, buffer, STREAM_BUFFER_SIZE);
+      success = processRLE(http, startTime, ImageFormat::Z2, firstRow, rowCount, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z3:
-      success = processRLE(http, startTime, ImageFormat::Z3, buffer, STREAM_BUFFER_SIZE);
+      success = processRLE(http, startTime, ImageFormat::Z3, firstRow, rowCount, buffer, STREAM_BUFFER_SIZE);
+      break;
+
+    case ImageFormat::Z4:
+      success = processZ4(http, startTime, firstRow, rowCount, buffer, STREAM_BUFFER_SIZE);
+      break;
+
+    case ImageFormat::ZP:
+      success = processPacked(http, startTime, firstRow, rowCount);
+      break;
+
+    case ImageFormat::ZL:
+      success = processZL(http, startTime, firstRow, rowCount, buffer, STREAM_BUFFER_SIZE);
       break;
 
     default:
@@ -1044,6 +2174,7 @@ void readImageData(HttpClient &http)
     Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Image processing failed\n");
     StateManager::setSleepDuration(StateManager::DEFAULT_SLEEP_SECONDS);
     StateManager::setTimestamp(0);
+    StateManager::setContentHash(nullptr);
   }
 
 #ifdef STREAMING_ENABLED
@@ -1057,6 +2188,12 @@ void readImageData(HttpClient &http)
 // Direct Streaming Public Interface
 ///////////////////////////////////////////////
 
+void getSupportedFormats(JsonArray formats)
+{
+  for (ImageFormat format : SUPPORTED_FORMATS)
+    formats.add(formatToString(format));
+}
+
 bool isDirectStreamingAvailable()
 {
 #if defined(STREAMING_ENABLED) && defined(STREAMING_DIRECT_MODE)
@@ -1126,23 +2263,39 @@ ImageStreamingResult readImageDataDirect(HttpClient &http)
     return ImageStreamingResult::FallbackToPaged;
   }
 
+  // Body source for the decoders, receiving on core 0 once a handler starts it (see network_reader.h).
+  // Stopped again when it goes out of scope, before anyone else touches the client.
+  NetworkReader reader(http);
+
   // Route to direct streaming format handlers
   switch (format)
   {
     case ImageFormat::PNG:
-      success = processPNGDirect(http, startTime, buffer, STREAM_BUFFER_SIZE);
+      success = processPNGDirect(http, reader, startTime, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z1:
-      success = processRLEDirect(http, startTime, ImageFormat::Z1, buffer, STREAM_BUFFER_SIZE);
+      success = processRLEDirect<ImageFormat::Z1>(reader, startTime, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z2:
-      success = processRLEDirect(http, startTime, ImageFormat::Z2, buffer, STREAM_BUFFER_SIZE);
+      success = processRLEDirect<ImageFormat::Z2>(reader, startTime, buffer, STREAM_BUFFER_SIZE);
       break;
 
     case ImageFormat::Z3:
-      success = processRLEDirect(http, startTime, ImageFormat::Z3, buffer, STREAM_BUFFER_SIZE);
+      success = processRLEDirect<ImageFormat::Z3>(reader, startTime, buffer, STREAM_BUFFER_SIZE);
+      break;
+
+    case ImageFormat::Z4:
+      success = processZ4Direct(reader, startTime, buffer, STREAM_BUFFER_SIZE);
+      break;
+
+    case ImageFormat::ZP:
+      success = processPackedDirect(http, reader, startTime);
+      break;
+
+    case ImageFormat::ZL:
+      success = processZLDirect(http, reader, startTime, buffer, STREAM_BUFFER_SIZE);
       break;
 
     default:
@@ -1159,6 +2312,7 @@ ImageStreamingResult readImageDataDirect(HttpClient &http)
     Logger::log<Logger::Level::ERROR, Logger::Topic::IMAGE>("Direct streaming failed\n");
     StateManager::setSleepDuration(StateManager::DEFAULT_SLEEP_SECONDS);
     StateManager::setTimestamp(0);
+    StateManager::setContentHash(nullptr);
   }
 
   streamMgr.cleanup();
@@ -23,6 +23,9 @@ ImageStreamingResult readImageDataDirect(HttpClient &http);
 
 // Check if direct streaming mode is available
 bool isDirectStreamingAvailable();
+
+// Names of the image formats this build decodes, for the request's capabilities
+void getSupportedFormats(JsonArray formats);
 } // namespace ImageHandler
 
 #endif // IMAGE_HANDLER_H
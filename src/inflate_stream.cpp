@@ -0,0 +1,217 @@
+#include "inflate_stream.h"
+
+#include "logger.h"
+
+#include <miniz.h>
+#include <new>
+
+constexpr size_t InflateStream::WINDOW_SIZE;
+
+// Gzip member header (RFC 1952): ID1 ID2 CM FLG MTIME(4) XFL OS, then the optional fields in FLG order
+static constexpr uint8_t GZIP_HEADER_SIZE = 10;
+static constexpr uint8_t GZIP_FHCRC = 0x02;
+static constexpr uint8_t GZIP_FEXTRA = 0x04;
+static constexpr uint8_t GZIP_FNAME = 0x08;
+static constexpr uint8_t GZIP_FCOMMENT = 0x10;
+static constexpr uint8_t GZIP_RESERVED = 0xE0;
+static constexpr uint8_t DEFLATE_METHOD = 8;
+
+InflateStream::InflateStream()
+    : m_decompressor(nullptr),
+      m_window(nullptr),
+      m_readPos(0),
+      m_writePos(0),
+      m_flags(0),
+      m_state(State::Done),
+      m_gzipFlags(0),
+      m_headerCount(0),
+      m_headerSkip(0),
+      m_totalIn(0),
+      m_totalOut(0)
+{
+}
+
+InflateStream::~InflateStream() { end(); }
+
+bool InflateStream::begin(Encoding encoding)
+{
+  end();
+
+  m_decompressor = new (std::nothrow) tinfl_decompressor;
+  m_window = new (std::nothrow) uint8_t[WINDOW_SIZE];
+  if (!m_decompressor || !m_window)
+  {
+    Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Not enough memory for inflate ({} + {} bytes)\n",
+                                                           sizeof(tinfl_decompressor), WINDOW_SIZE);
+    end();
+    return false;
+  }
+
+  tinfl_init(m_decompressor);
+  m_readPos = m_writePos = 0;
+  m_flags = 0;
+  m_state = (encoding == Encoding::Gzip) ? State::GzipHeader : State::DeflateHeader;
+  m_gzipFlags = 0;
+  m_headerCount = 0;
+  m_headerSkip = 0;
+  m_totalIn = m_totalOut = 0;
+  return true;
+}
+
+void InflateStream::end()
+{
+  delete m_decompressor;
+  m_decompressor = nullptr;
+  delete[] m_window;
+  m_window = nullptr;
+  m_readPos = m_writePos = 0;
+  m_state = State::Done;
+}
+
+void InflateStream::fail(const char *reason)
+{
+  Logger::log<Logger::Level::ERROR, Logger::Topic::HTTP>("Inflate failed: {}\n", reason);
+  m_state = State::Failed;
+}
+
+// Skip the gzip header, returns the bytes consumed
+size_t InflateStream::parseGzipHeader(const uint8_t *in, size_t length)
+{
+  size_t pos = 0;
+  while (m_state == State::GzipHeader && pos < length)
+  {
+    uint8_t c = in[pos++];
+
+    if (m_headerCount < GZIP_HEADER_SIZE)
+    {
+      if ((m_headerCount == 0 && c != 0x1F) || (m_headerCount == 1 && c != 0x8B) ||
+          (m_headerCount == 2 && c != DEFLATE_METHOD) || (m_headerCount == 3 && (c & GZIP_RESERVED)))
+      {
+        fail("invalid gzip header");
+        return pos;
+      }
+      if (m_headerCount == 3)
+        m_gzipFlags = c;
+      m_headerCount++;
+    }
+    else if (m_gzipFlags & GZIP_FEXTRA)
+    {
+      // Little endian length, then that many bytes
+      if (m_headerCount < GZIP_HEADER_SIZE + 2)
+      {
+        m_headerSkip |= (uint16_t)c << (8 * (m_headerCount++ - GZIP_HEADER_SIZE));
+        if (m_headerCount == GZIP_HEADER_SIZE + 2 && m_headerSkip == 0)
+          m_gzipFlags &= ~GZIP_FEXTRA;
+      }
+      else if (--m_headerSkip == 0)
+      {
+        m_gzipFlags &= ~GZIP_FEXTRA;
+      }
+    }
+    else if (m_gzipFlags & GZIP_FNAME)
+    {
+      if (c == 0)
+        m_gzipFlags &= ~GZIP_FNAME;
+    }
+    else if (m_gzipFlags & GZIP_FCOMMENT)
+    {
+      if (c == 0)
+        m_gzipFlags &= ~GZIP_FCOMMENT;
+    }
+    else if (m_gzipFlags & GZIP_FHCRC)
+    {
+      if (++m_headerSkip == 2)
+        m_gzipFlags &= ~GZIP_FHCRC;
+    }
+
+    if (m_headerCount >= GZIP_HEADER_SIZE && m_gzipFlags == 0)
+      m_state = State::Body;
+  }
+
+  return pos;
+}
+
+// "deflate" should be zlib wrapped, but some servers send raw deflate; tell them apart by the first byte.
+// A back-reference past the window would silently repeat wrong bytes, so the window has to be known:
+// stated in the zlib header, or a raw stream only with the full 32 KB window.
+bool InflateStream::checkDeflateHeader(uint8_t first)
+{
+  uint8_t method = first & 0x0F;
+  uint8_t windowBits = (first >> 4) + 8;
+
+  if (method == DEFLATE_METHOD && windowBits <= 15)
+  {
+    if (windowBits > HTTP_INFLATE_WINDOW_BITS)
+    {
+      fail("server window larger than HTTP_INFLATE_WINDOW_BITS");
+      return false;
+    }
+    m_flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+  }
+  else if (HTTP_INFLATE_WINDOW_BITS < 15)
+  {
+    fail("raw deflate without window size");
+    return false;
+  }
+
+  m_state = State::Body;
+  return true;
+}
+
+bool InflateStream::decode(const uint8_t *in, size_t &inLength, bool moreInput)
+{
+  size_t available = inLength;
+  inLength = 0;
+
+  if (m_state == State::GzipHeader)
+  {
+    inLength = parseGzipHeader(in, available);
+    in += inLength;
+    available -= inLength;
+  }
+  else if (m_state == State::DeflateHeader && available > 0 && !checkDeflateHeader(in[0]))
+  {
+    return false;
+  }
+
+  if (m_state == State::Failed)
+    return false;
+
+  if (m_state != State::Body)
+  {
+    if (moreInput)
+      return true; // Header continues in the next read
+    fail("body ended in header");
+    return false;
+  }
+
+  // Everything handed out, start over at the beginning of the window once it is full
+  if (m_writePos == WINDOW_SIZE)
+    m_readPos = m_writePos = 0;
+
+  size_t inBytes = available;
+  size_t outBytes = WINDOW_SIZE - m_writePos;
+  tinfl_status status =
+    tinfl_decompress(m_decompressor, in, &inBytes, m_window, m_window + m_writePos, &outBytes,
+                     m_flags | (moreInput ? TINFL_FLAG_HAS_MORE_INPUT : 0));
+
+  inLength += inBytes;
+  m_writePos += outBytes;
+  m_totalIn += inLength;
+  m_totalOut += outBytes;
+
+  if (status == TINFL_STATUS_DONE)
+  {
+    m_state = State::Done;
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Inflated {} -> {} bytes\n", m_totalIn, m_totalOut);
+    return true;
+  }
+
+  if (status < 0 || (status == TINFL_STATUS_NEEDS_MORE_INPUT && !moreInput))
+  {
+    fail(moreInput ? "corrupt data" : "body ended before end of stream");
+    return false;
+  }
+
+  return true;
+}
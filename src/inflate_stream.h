@@ -0,0 +1,96 @@
+#ifndef INFLATE_STREAM_H
+#define INFLATE_STREAM_H
+
+#include <Arduino.h>
+#include <cstdint>
+
+// Inflate window is 2^bits bytes, the server must not compress with a larger one (zlib wbits). It is sent as
+// X-Inflate-Window-Bits and only zlib-wrapped deflate is requested, the window in its header is checked.
+// gzip and raw deflate state no window and are only accepted with 15 bits (32 KB, any stream fits).
+// 12 (4 KB) keeps decompressor state plus window around 15 KB, next to the row buffer on ESP32-WROOM.
+#ifndef HTTP_INFLATE_WINDOW_BITS
+  #define HTTP_INFLATE_WINDOW_BITS 12
+#endif
+
+#if HTTP_INFLATE_WINDOW_BITS < 8 || HTTP_INFLATE_WINDOW_BITS > 15
+  #error "HTTP_INFLATE_WINDOW_BITS must be between 8 and 15"
+#endif
+
+// Defined by miniz (bundled with pngle)
+struct tinfl_decompressor_tag;
+
+// Streaming gzip/deflate decoder for HTTP Content-Encoding.
+// Output lands in a wrapping window buffer and is read from there in place,
+// so memory use is fixed no matter how large the body is.
+class InflateStream
+{
+public:
+  enum class Encoding : uint8_t
+  {
+    Gzip,   // RFC 1952 member header + raw deflate
+    Deflate // zlib wrapped (RFC 1950), raw deflate is accepted as well
+  };
+
+  static constexpr size_t WINDOW_SIZE = (size_t)1 << HTTP_INFLATE_WINDOW_BITS;
+
+  InflateStream();
+  ~InflateStream();
+
+  // Prevent copying
+  InflateStream(const InflateStream &) = delete;
+  InflateStream &operator=(const InflateStream &) = delete;
+
+  // Allocate decompressor and window, false if there is not enough heap
+  bool begin(Encoding encoding);
+  void end();
+
+  bool isActive() const { return m_decompressor != nullptr; }
+
+  // Nothing more will be produced beyond what is buffered (stream end or error)
+  bool isFinished() const { return m_state == State::Done || m_state == State::Failed; }
+  bool hasFailed() const { return m_state == State::Failed; }
+
+  // Decode input into the window, only call once everything buffered is consumed.
+  // inLength is updated to the bytes actually used; moreInput is false once the compressed body has ended.
+  // Returns false on corrupt or truncated data.
+  bool decode(const uint8_t *in, size_t &inLength, bool moreInput);
+
+  // Decoded bytes not consumed yet
+  const uint8_t *data() const { return m_window + m_readPos; }
+  size_t buffered() const { return m_writePos - m_readPos; }
+  void consume(size_t bytes) { m_readPos += bytes; }
+
+  uint32_t getTotalIn() const { return m_totalIn; }
+  uint32_t getTotalOut() const { return m_totalOut; }
+
+private:
+  enum class State : uint8_t
+  {
+    GzipHeader,
+    DeflateHeader,
+    Body,
+    Done,
+    Failed
+  };
+
+  tinfl_decompressor_tag *m_decompressor;
+  uint8_t *m_window;
+  size_t m_readPos;
+  size_t m_writePos;
+  uint32_t m_flags; // TINFL_FLAG_* for this stream
+  State m_state;
+
+  // Gzip header parsing, the header may arrive split across reads
+  uint8_t m_gzipFlags; // Optional fields still to skip
+  uint8_t m_headerCount;
+  uint16_t m_headerSkip;
+
+  uint32_t m_totalIn;
+  uint32_t m_totalOut;
+
+  size_t parseGzipHeader(const uint8_t *in, size_t length);
+  bool checkDeflateHeader(uint8_t first);
+  void fail(const char *reason);
+};
+
+#endif // INFLATE_STREAM_H
@@ -52,6 +52,13 @@ public:
     // Empty - optimized away
   }
 
+  // Compile-time check for code that only exists to produce log output
+  template <Level L>
+  static constexpr bool isEnabled()
+  {
+    return L >= LOG_LEVEL_MINIMUM;
+  }
+
   // Convenience wrapper: Only Topic specified, Level defaults to INFO
   template <Topic T, typename... Args>
   static void log(const String &format, Args... args)
@@ -59,6 +59,7 @@ void configModeCallback()
 
   // Reset timestamp to force update when reconnected
   StateManager::setTimestamp(0);
+  StateManager::setContentHash(nullptr);
 
   // Show WiFi configuration screen on display only if ShowNoWifiError is enabled (default: 1)
   if (StateManager::getShowNoWifiError() == 1)
@@ -203,6 +204,10 @@ void downloadAndDisplayImage(HttpClient &httpClient)
 
     // Store number of pages needed to fill the buffer of the display to turn off the WiFi after last page is loaded
     uint16_t pagesToLoad = Display::getNumberOfPages();
+    uint16_t page = 0;
+
+    // Page requests follow each other immediately, send them over one connection
+    httpClient.setKeepAlive(pagesToLoad > 1);
 
     do
     {
@@ -212,11 +217,20 @@ void downloadAndDisplayImage(HttpClient &httpClient)
         Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Using existing connection from timestamp check\n");
         imageReady = false; // Only reuse once; subsequent pages need fresh downloads
       }
-      else if (!httpClient.startImageDownload())
+      else
       {
-        break;
+        // Ask only for the rows that end up in this page
+        uint16_t firstRow = 0;
+        uint16_t rowCount = 0;
+        if (Display::getPageRows(page, firstRow, rowCount))
+          Logger::log<Logger::Level::DEBUG, Logger::Topic::IMAGE>("Page {}: requesting rows {}-{}\n", page, firstRow,
+                                                                  firstRow + rowCount - 1);
+
+        if (!httpClient.startImageDownload(firstRow, rowCount))
+          break;
       }
       ImageHandler::readImageData(httpClient);
+      page++;
 
       // turn of WiFi if no more pages left
       if (--pagesToLoad == 0)
@@ -304,6 +318,7 @@ void handleDisconnectedState()
 
   // Reset timestamp to force update on next successful connection
   StateManager::setTimestamp(0);
+  StateManager::setContentHash(nullptr);
 
   // Show error message on display only if ShowNoWifiError is enabled (default: 1)
   if (StateManager::getShowNoWifiError() == 1)
@@ -0,0 +1,222 @@
+#include "network_reader.h"
+
+#include "logger.h"
+
+#include <new>
+
+constexpr size_t NetworkReader::MIN_RING_SIZE;
+
+NetworkReader::NetworkReader(HttpClient &http)
+    : m_http(http),
+      m_ring(nullptr),
+      m_ringSize(0),
+      m_head(0),
+      m_tail(0),
+      m_finished(true),
+      m_stopRequested(false),
+      m_pipelined(false),
+      m_consumer(nullptr),
+      m_startOffset(0)
+{
+}
+
+NetworkReader::~NetworkReader()
+{
+  stop();
+  delete[] m_ring;
+}
+
+void NetworkReader::start()
+{
+#ifdef NETWORK_PIPELINE_ENABLED
+  if (m_pipelined)
+    return;
+
+  if (!allocateRing())
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("No memory for network ring buffer, reading inline\n");
+    return;
+  }
+
+  if (startTask())
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("Network reader task started ({} byte ring)\n",
+                                                           m_ringSize);
+#endif
+}
+
+void NetworkReader::stop()
+{
+  if (!m_pipelined)
+    return;
+
+  m_stopRequested.store(true, std::memory_order_relaxed);
+  waitForTask();
+  m_pipelined = false;
+}
+
+// Largest power of two that fits, down to MIN_RING_SIZE
+bool NetworkReader::allocateRing()
+{
+  if (m_ring)
+    return true;
+
+  for (size_t size = NETWORK_RING_BUFFER_SIZE; size >= MIN_RING_SIZE; size /= 2)
+  {
+    m_ring = new (std::nothrow) uint8_t[size];
+    if (m_ring)
+    {
+      m_ringSize = size;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool NetworkReader::startTask()
+{
+  m_head.store(0, std::memory_order_relaxed);
+  m_tail.store(0, std::memory_order_relaxed);
+  m_finished.store(false, std::memory_order_relaxed);
+  m_stopRequested.store(false, std::memory_order_relaxed);
+  m_startOffset = m_http.getBodyOffset();
+  m_consumer = xTaskGetCurrentTaskHandle();
+
+  if (xTaskCreatePinnedToCore(readerTask, "netReader", NETWORK_READER_STACK_SIZE, this, READER_PRIORITY, nullptr,
+                              READER_CORE) != pdPASS)
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("Failed to start network reader task, reading inline\n");
+    m_finished.store(true, std::memory_order_relaxed);
+    return false;
+  }
+
+  m_pipelined = true;
+  return true;
+}
+
+void NetworkReader::waitForTask()
+{
+  while (!m_finished.load(std::memory_order_acquire))
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WAIT_SLICE_MS));
+}
+
+void NetworkReader::readerTask(void *param)
+{
+  NetworkReader *reader = static_cast<NetworkReader *>(param);
+  TaskHandle_t consumer = reader->m_consumer;
+
+  reader->receiveLoop();
+
+  // The reader may be gone as soon as m_finished is seen, only locals from here on
+  reader->m_finished.store(true, std::memory_order_release);
+  xTaskNotifyGive(consumer);
+  vTaskDelete(nullptr);
+}
+
+// Producer side: receive into the free part of the ring until the body ends
+void NetworkReader::receiveLoop()
+{
+  const uint32_t mask = m_ringSize - 1;
+
+  while (!m_stopRequested.load(std::memory_order_relaxed))
+  {
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    uint32_t space = m_ringSize - (head - m_tail.load(std::memory_order_acquire));
+    if (space == 0)
+    {
+      // Decoder is behind, the socket buffers the rest meanwhile
+      vTaskDelay(1);
+      continue;
+    }
+
+    if (!m_http.isConnected() && !m_http.available())
+      break;
+
+    uint32_t index = head & mask;
+    uint32_t contiguous = m_ringSize - index;
+    uint32_t received = m_http.readInto(m_ring + index, (space < contiguous) ? space : contiguous);
+    if (received == 0)
+      break;
+
+    m_head.store(head + received, std::memory_order_release);
+    xTaskNotifyGive(m_consumer);
+  }
+}
+
+// Consumer side: copy out of the ring, waiting for the reader task while it is empty
+uint32_t NetworkReader::readInto(uint8_t *buf, uint32_t maxBytes)
+{
+  if (!m_pipelined)
+    return m_http.readInto(buf, maxBytes);
+
+  if (maxBytes == 0)
+    return 0;
+
+  uint32_t tail = m_tail.load(std::memory_order_relaxed);
+  uint32_t used;
+  while (true)
+  {
+    // Final head is published before m_finished
+    bool finished = m_finished.load(std::memory_order_acquire);
+    used = m_head.load(std::memory_order_acquire) - tail;
+    if (used > 0)
+      break;
+    if (finished)
+      return 0;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WAIT_SLICE_MS));
+  }
+
+  uint32_t count = (used < maxBytes) ? used : maxBytes;
+  uint32_t index = tail & (m_ringSize - 1);
+  uint32_t first = m_ringSize - index;
+  if (first > count)
+    first = count;
+
+  memcpy(buf, m_ring + index, first);
+  memcpy(buf + first, m_ring, count - first);
+  m_tail.store(tail + count, std::memory_order_release);
+
+  return count;
+}
+
+bool NetworkReader::isConnected()
+{
+  if (!m_pipelined)
+    return m_http.isConnected();
+  return !m_finished.load(std::memory_order_acquire) || buffered() > 0;
+}
+
+int NetworkReader::available()
+{
+  if (!m_pipelined)
+    return m_http.available();
+  return buffered();
+}
+
+uint32_t NetworkReader::getBodyOffset() const
+{
+  if (!m_pipelined)
+    return m_http.getBodyOffset();
+  return m_startOffset + m_tail.load(std::memory_order_relaxed);
+}
+
+bool NetworkReader::isBodyComplete() const
+{
+  // HttpClient belongs to the reader task until it finished
+  if (m_pipelined && !m_finished.load(std::memory_order_acquire))
+    return false;
+  return m_http.isBodyComplete();
+}
+
+bool NetworkReader::resumeDownload(uint32_t offset)
+{
+  bool wasPipelined = m_pipelined;
+  stop();
+
+  if (!m_http.resumeDownload(offset))
+    return false;
+
+  if (wasPipelined)
+    startTask();
+  return true;
+}
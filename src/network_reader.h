@@ -0,0 +1,101 @@
+#ifndef NETWORK_READER_H
+#define NETWORK_READER_H
+
+// Network/decoder pipeline - enabled by default on dual-core targets.
+// A reader task on core 0 receives (and decrypts) the image body into a ring buffer
+// while the decoder, pixel packing and SPI writes run on the loop task's core.
+#if !defined(NETWORK_PIPELINE_DISABLED) && !defined(CONFIG_FREERTOS_UNICORE)
+  #define NETWORK_PIPELINE_ENABLED
+#endif
+
+#ifndef NETWORK_RING_BUFFER_SIZE
+  #define NETWORK_RING_BUFFER_SIZE 8192 // Power of two, halved down to the minimum when heap is short
+#endif
+
+#ifndef NETWORK_READER_STACK_SIZE
+  #define NETWORK_READER_STACK_SIZE 6144 // TLS record decryption runs on this stack
+#endif
+
+#include <Arduino.h>
+#include <atomic>
+#include <cstdint>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "http_client.h"
+
+// Image body source for the decoders, same read interface as HttpClient.
+// Pipelined: a task pinned to core 0 fills a lock-free single-producer/single-consumer ring.
+// Synchronous (single-core, pipeline disabled, or no memory for the ring): reads go straight to HttpClient.
+// While the reader task runs, HttpClient must only be used through this class.
+class NetworkReader
+{
+public:
+  explicit NetworkReader(HttpClient &http);
+  ~NetworkReader();
+
+  // Prevent copying
+  NetworkReader(const NetworkReader &) = delete;
+  NetworkReader &operator=(const NetworkReader &) = delete;
+
+  // Start the reader task, stays synchronous if that is not possible
+  void start();
+  void stop();
+
+  bool isPipelined() const { return m_pipelined; }
+
+  // Heap start() takes once the band is allocated: full ring, task stack and control block
+  static constexpr size_t getHeapReserve()
+  {
+#ifdef NETWORK_PIPELINE_ENABLED
+    return NETWORK_RING_BUFFER_SIZE + NETWORK_READER_STACK_SIZE + TASK_OVERHEAD;
+#else
+    return 0;
+#endif
+  }
+
+  // Read whatever is received (waits only for the first byte), up to maxBytes
+  uint32_t readInto(uint8_t *buf, uint32_t maxBytes);
+
+  bool isConnected();
+  int available();
+
+  // Body bytes handed to the decoder so far
+  uint32_t getBodyOffset() const;
+
+  // Only meaningful once reads have returned 0
+  bool isBodyComplete() const;
+
+  // Reconnect and continue at offset, see HttpClient::resumeDownload
+  bool resumeDownload(uint32_t offset);
+
+private:
+  static constexpr size_t MIN_RING_SIZE = 2048;
+  static constexpr size_t TASK_OVERHEAD = 512; // TCB and allocator headers
+  static constexpr uint32_t WAIT_SLICE_MS = 250;
+  static constexpr BaseType_t READER_CORE = 0; // Same core as the WiFi/lwIP tasks
+  static constexpr UBaseType_t READER_PRIORITY = 2;
+
+  HttpClient &m_http;
+
+  uint8_t *m_ring;
+  size_t m_ringSize;
+  std::atomic<uint32_t> m_head; // Written by the reader task only, free running
+  std::atomic<uint32_t> m_tail; // Written by the decoder only, free running
+  std::atomic<bool> m_finished; // Reader task stopped receiving (body end, error or stop request)
+  std::atomic<bool> m_stopRequested;
+
+  bool m_pipelined;
+  TaskHandle_t m_consumer; // Notified by the reader task after each receive
+  uint32_t m_startOffset;  // Body offset when the reader task started
+
+  bool allocateRing();
+  bool startTask();
+  void waitForTask();
+  uint32_t buffered() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed); }
+  static void readerTask(void *param);
+  void receiveLoop();
+};
+
+#endif // NETWORK_READER_H
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <cstdint>
+#include <cstring>
 
 #include "display.h"
 
@@ -19,20 +20,6 @@ enum class DisplayFormat : uint8_t
   COLOR_7C = CT_7C          // 4bpp 7-color
 };
 
-// Color values in RGB565 format
-enum class GxEPDColor : uint16_t
-{
-  BLACK = 0x0000,    // R=0, G=0, B=0
-  WHITE = 0xFFFF,    // R=31, G=63, B=31
-  RED = 0xF800,      // R=31, G=0, B=0
-  YELLOW = 0xFFE0,   // R=31, G=63, B=0
-  GREEN = 0x07E0,    // R=0, G=63, B=0 (6E/7C displays only)
-  BLUE = 0x001F,     // R=0, G=0, B=31 (6E/7C displays only)
-  ORANGE = 0xFD20,   // R=31, G=41, B=0 (7C displays only)
-  DARKGREY = 0x7BEF, // R=15, G=31, B=15 (Grayscale displays)
-  LIGHTGREY = 0xC618 // R=24, G=48, B=24 (Grayscale displays)
-};
-
 // White byte patterns for buffer initialization
 constexpr uint8_t WHITE_BYTE_1BPP = 0xFF;
 constexpr uint8_t WHITE_BYTE_2BPP = 0xFF;
@@ -41,16 +28,61 @@ constexpr uint8_t WHITE_BYTE_4C = 0x55;
 
 inline constexpr DisplayFormat getDisplayFormat() { return static_cast<DisplayFormat>(COLOR_ID); }
 
+// Bits per pixel of the compiled display format (per plane for 3C)
+#if defined(TYPE_GRAYSCALE) || defined(TYPE_4C)
+constexpr uint8_t NATIVE_BITS_PER_PIXEL = 2;
+#elif defined(TYPE_7C)
+constexpr uint8_t NATIVE_BITS_PER_PIXEL = 4;
+#else
+constexpr uint8_t NATIVE_BITS_PER_PIXEL = 1;
+#endif
+
+// Stream palette index (Z formats, quantized PNG) -> native pixel code of the compiled display format.
+// Index 0 white, 1 black, 2/3 second/third color, 4-6 green/blue/orange (7C), same colors as the RGB565
+// palette the paged (GFX) path draws with. Direct streaming packs these codes without any RGB565 detour.
+// 3C: bit 0 = black plane bit, bit 1 = color plane bit (0 = inked).
+// 8G (epdiy) never streams directly, it gets the BW layout only to keep the decoders compiling.
+constexpr uint8_t NATIVE_PALETTE[8] = {
+#if defined(TYPE_GRAYSCALE)
+  3, 0, 2, 1, 3, 3, 3, 3 // White, black, light grey, dark grey
+#elif defined(TYPE_3C)
+  3, 2, 1, 1, 3, 3, 3, 3 // White, black, red, yellow
+#elif defined(TYPE_4C)
+  1, 0, 3, 2, 1, 1, 1, 1 // White, black, red, yellow
+#elif defined(TYPE_7C)
+  1, 0, 4, 5, 2, 3, 6, 1 // White, black, red, yellow, green, blue, orange
+#else
+  1, 0, 1, 1, 1, 1, 1, 1 // Only black is black
+#endif
+};
+constexpr uint8_t PALETTE_SIZE = sizeof(NATIVE_PALETTE) / sizeof(NATIVE_PALETTE[0]);
+
+// Byte filled with one native code, 3C: black plane pattern in the low byte, color plane pattern in the high byte
+constexpr uint16_t nativePattern(uint8_t code)
+{
+#ifdef TYPE_3C
+  return ((code & 0x01) ? 0x00FF : 0x0000) | ((code & 0x02) ? 0xFF00 : 0x0000);
+#else
+  return code * ((NATIVE_BITS_PER_PIXEL == 1) ? 0xFF : (NATIVE_BITS_PER_PIXEL == 2) ? 0x55 : 0x11);
+#endif
+}
+
+// Palette index -> fill pattern, for run-length decoders
+constexpr uint16_t RUN_PATTERNS[PALETTE_SIZE] = {
+  nativePattern(NATIVE_PALETTE[0]), nativePattern(NATIVE_PALETTE[1]), nativePattern(NATIVE_PALETTE[2]),
+  nativePattern(NATIVE_PALETTE[3]), nativePattern(NATIVE_PALETTE[4]), nativePattern(NATIVE_PALETTE[5]),
+  nativePattern(NATIVE_PALETTE[6]), nativePattern(NATIVE_PALETTE[7])};
+
 // Check if direct streaming is supported for the current display format
 // All display types now support the setPaged()/writeNative()/refresh() API
 inline constexpr bool supportsDirectStreaming() { return true; }
 
 size_t getRowBufferSize(uint16_t width, DisplayFormat format);
 uint8_t getBitsPerPixel(DisplayFormat format);
+const char *getFormatName(DisplayFormat format);
 
 void packPixelBW(uint8_t *buffer, uint16_t x, bool isBlack);
 void packPixel4G(uint8_t *buffer, uint16_t x, uint8_t grey);
-void packPixel3C(uint8_t *blackBuffer, uint8_t *colorBuffer, uint16_t x, uint16_t color);
 void packPixel4C(uint8_t *buffer, uint16_t x, uint8_t color4);
 void packPixel7C(uint8_t *buffer, uint16_t x, uint8_t color7);
 
@@ -58,14 +90,63 @@ void packPixel7C(uint8_t *buffer, uint16_t x, uint8_t color7);
 // Much faster than calling packPixel* per pixel; uses memset for aligned sections.
 void fillPixelRunBW(uint8_t *buffer, uint16_t startX, uint16_t count, bool isBlack);
 void fillPixelRunGrayscale(uint8_t *buffer, uint16_t startX, uint16_t count, uint8_t grey);
-void fillPixelRun3C(uint8_t *blackBuffer, uint8_t *colorBuffer, uint16_t startX, uint16_t count, uint16_t color);
 void fillPixelRun4C(uint8_t *buffer, uint16_t startX, uint16_t count, uint8_t color4);
 void fillPixelRun7C(uint8_t *buffer, uint16_t startX, uint16_t count, uint8_t color7);
 
+// Set one pixel to a native code (BitsPerPixel wide), MSB first layout
+template <uint8_t BitsPerPixel>
+inline void packNativePixel(uint8_t *buffer, uint16_t x, uint8_t code)
+{
+  const uint32_t bit = (uint32_t)x * BitsPerPixel;
+  const uint8_t shift = (uint8_t)(8u - BitsPerPixel - (bit & 7u));
+  const uint8_t mask = (uint8_t)(((1u << BitsPerPixel) - 1u) << shift);
+  buffer[bit >> 3u] = (uint8_t)((buffer[bit >> 3u] & ~mask) | ((code << shift) & mask));
+}
+
+// Native code of one pixel, inverse of packNativePixel
+template <uint8_t BitsPerPixel>
+inline uint8_t unpackNativePixel(const uint8_t *buffer, uint16_t x)
+{
+  const uint32_t bit = (uint32_t)x * BitsPerPixel;
+  const uint8_t shift = (uint8_t)(8u - BitsPerPixel - (bit & 7u));
+  return (uint8_t)((buffer[bit >> 3u] >> shift) & ((1u << BitsPerPixel) - 1u));
+}
+
+// Fill count pixels from startX with a byte of identical pixels (pattern), MSB first layout.
+// Masks the partial first/last bytes and memsets the rest, shared by all fill functions.
+template <uint8_t BitsPerPixel>
+inline void fillPackedRun(uint8_t *buffer, uint16_t startX, uint16_t count, uint8_t pattern)
+{
+  static_assert(BitsPerPixel == 1 || BitsPerPixel == 2 || BitsPerPixel == 4, "Unsupported pixel size");
+
+  if (count == 0)
+    return;
+
+  const uint32_t startBit = (uint32_t)startX * BitsPerPixel;
+  const uint32_t endBit = startBit + (uint32_t)count * BitsPerPixel; // exclusive
+  const uint32_t startByte = startBit >> 3u;
+  const uint32_t endByte = (endBit - 1u) >> 3u; // inclusive
+
+  // headMask = bits from the first pixel to the end of its byte, tailMask = bits up to the end of the last pixel
+  const uint8_t headMask = (uint8_t)(0xFFu >> (startBit & 7u));
+  const uint8_t tailMask = (uint8_t)(0xFF00u >> (((endBit - 1u) & 7u) + 1u));
+
+  if (startByte == endByte)
+  {
+    const uint8_t mask = headMask & tailMask;
+    buffer[startByte] = (uint8_t)((buffer[startByte] & ~mask) | (pattern & mask));
+    return;
+  }
+
+  buffer[startByte] = (uint8_t)((buffer[startByte] & ~headMask) | (pattern & headMask));
+
+  if (endByte > startByte + 1u)
+    memset(buffer + startByte + 1u, pattern, endByte - startByte - 1u);
+
+  buffer[endByte] = (uint8_t)((buffer[endByte] & ~tailMask) | (pattern & tailMask));
+}
+
 size_t convertGrayscaleToBW(uint8_t *buffer, uint16_t width, uint16_t rowCount);
-uint8_t gxepdToGrey(uint16_t color);
-uint8_t gxepdTo4CColor(uint16_t color);
-uint8_t gxepdTo7CColor(uint16_t color);
 
 void initRowBuffer(uint8_t *buffer, size_t size, DisplayFormat format);
 
@@ -1,11 +1,41 @@
 #include "state_manager.h"
 
+#include "board.h"
+#include "logger.h"
+
+#include <math.h>
+
+// Compact telemetry: full payload every Nth wake and when a value moves past its threshold
+#ifndef TELEMETRY_FULL_EVERY_N_WAKES
+  #define TELEMETRY_FULL_EVERY_N_WAKES 10
+#endif
+#ifndef TELEMETRY_RSSI_THRESHOLD
+  #define TELEMETRY_RSSI_THRESHOLD 10 // dBm
+#endif
+#ifndef TELEMETRY_VOLTAGE_THRESHOLD
+  #define TELEMETRY_VOLTAGE_THRESHOLD 0.1f // V
+#endif
+#ifndef TELEMETRY_TEMPERATURE_THRESHOLD
+  #define TELEMETRY_TEMPERATURE_THRESHOLD 1.0f // °C
+#endif
+
 // RTC persistent data (survives deep sleep)
 RTC_DATA_ATTR uint64_t rtc_timestamp = 0;
+RTC_DATA_ATTR char rtc_contentHash[StateManager::CONTENT_HASH_MAX_LENGTH + 1] = {};
+RTC_DATA_ATTR uint16_t rtc_contentRenderSettings = 0;
 RTC_DATA_ATTR uint8_t rtc_failureCount = 0;
 RTC_DATA_ATTR unsigned long rtc_lastDownloadDuration = 0;
 RTC_DATA_ATTR unsigned long rtc_lastRefreshDuration = 0;
+RTC_DATA_ATTR unsigned long rtc_lastHandshakeDuration = 0;
+RTC_DATA_ATTR uint32_t rtc_firstByteLatency = 0;
+RTC_DATA_ATTR uint32_t rtc_receiveGap = 0;
+RTC_DATA_ATTR uint16_t rtc_streamingRows = 0;
+RTC_DATA_ATTR uint32_t rtc_downloadThroughput = 0;
+RTC_DATA_ATTR StateManager::DownloadMetrics rtc_downloadMetrics = {};
 RTC_DATA_ATTR uint8_t rtc_showNoWifiError = 1;
+RTC_DATA_ATTR uint8_t rtc_wakesSinceFullTelemetry = 0;
+RTC_DATA_ATTR bool rtc_hasFullTelemetry = false;
+RTC_DATA_ATTR StateManager::TelemetrySnapshot rtc_lastFullTelemetry = {};
 
 namespace StateManager
 {
@@ -20,6 +50,23 @@ uint64_t getTimestamp() { return rtc_timestamp; }
 
 void setTimestamp(uint64_t ts) { rtc_timestamp = ts; }
 
+void setContentHash(const char *hash, uint16_t renderSettings)
+{
+  if (!hash || strlen(hash) > CONTENT_HASH_MAX_LENGTH)
+  {
+    rtc_contentHash[0] = '\0';
+    rtc_contentRenderSettings = 0;
+    return;
+  }
+  strcpy(rtc_contentHash, hash);
+  rtc_contentRenderSettings = renderSettings;
+}
+
+bool isContentUnchanged(const char *hash, uint16_t renderSettings)
+{
+  return hash[0] != '\0' && strcmp(hash, rtc_contentHash) == 0 && renderSettings == rtc_contentRenderSettings;
+}
+
 void startDownloadTimer() { downloadStartTime = millis(); }
 
 void endDownloadTimer()
@@ -50,6 +97,45 @@ unsigned long getLastRefreshDuration() { return rtc_lastRefreshDuration; }
 
 void setLastRefreshDuration(unsigned long duration) { rtc_lastRefreshDuration = duration; }
 
+unsigned long getLastHandshakeDuration() { return rtc_lastHandshakeDuration; }
+
+void setLastHandshakeDuration(unsigned long duration) { rtc_lastHandshakeDuration = duration; }
+
+// Exponential moving average with weight 1/4 for the new sample, first sample taken as is
+static uint32_t updateAverage(uint32_t average, uint32_t sample)
+{
+  return (average == 0) ? sample : (average * 3 + sample) / 4;
+}
+
+uint32_t getFirstByteLatency() { return rtc_firstByteLatency; }
+
+void recordFirstByteLatency(uint32_t ms) { rtc_firstByteLatency = updateAverage(rtc_firstByteLatency, ms); }
+
+uint32_t getReceiveGap() { return rtc_receiveGap; }
+
+void recordReceiveGap(uint32_t ms) { rtc_receiveGap = updateAverage(rtc_receiveGap, ms); }
+
+uint16_t getStreamingRows() { return rtc_streamingRows; }
+
+void setStreamingRows(uint16_t rows) { rtc_streamingRows = rows; }
+
+uint32_t getDownloadThroughput() { return rtc_downloadThroughput; }
+
+void recordDownloadThroughput(uint32_t bytesPerSecond)
+{
+  rtc_downloadThroughput = updateAverage(rtc_downloadThroughput, bytesPerSecond);
+}
+
+const DownloadMetrics &getDownloadMetrics() { return rtc_downloadMetrics; }
+
+void setDownloadMetrics(const DownloadMetrics &metrics)
+{
+  rtc_downloadMetrics = metrics;
+  rtc_downloadMetrics.reported = false;
+}
+
+void markDownloadMetricsReported() { rtc_downloadMetrics.reported = true; }
+
 uint8_t getFailureCount() { return rtc_failureCount; }
 
 void incrementFailureCount()
@@ -84,4 +170,52 @@ uint8_t getShowNoWifiError() { return rtc_showNoWifiError; }
 
 void setShowNoWifiError(uint8_t value) { rtc_showNoWifiError = value; }
 
+bool isFullTelemetryDue(const TelemetrySnapshot &current)
+{
+  if (!rtc_hasFullTelemetry || Board::getResetReason() != ResetReason::DEEPSLEEP)
+    return true;
+
+  if (rtc_wakesSinceFullTelemetry + 1 >= TELEMETRY_FULL_EVERY_N_WAKES)
+    return true;
+
+  const TelemetrySnapshot &last = rtc_lastFullTelemetry;
+  if (abs(current.rssi - last.rssi) >= TELEMETRY_RSSI_THRESHOLD)
+  {
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::SYSTEM>("RSSI moved {} -> {} dBm\n", last.rssi, current.rssi);
+    return true;
+  }
+
+  if (fabsf(current.voltage - last.voltage) >= TELEMETRY_VOLTAGE_THRESHOLD)
+  {
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::SYSTEM>("Voltage moved {} -> {} V\n", last.voltage,
+                                                             current.voltage);
+    return true;
+  }
+
+  // Also covers a sensor appearing or disappearing (NAN on one side)
+  if (isnan(current.temperature) != isnan(last.temperature) ||
+      fabsf(current.temperature - last.temperature) >= TELEMETRY_TEMPERATURE_THRESHOLD)
+  {
+    Logger::log<Logger::Level::DEBUG, Logger::Topic::SYSTEM>("Temperature moved {} -> {} °C\n",
+                                                             last.temperature, current.temperature);
+    return true;
+  }
+
+  return false;
+}
+
+void recordTelemetrySent(bool full, const TelemetrySnapshot &current)
+{
+  if (full)
+  {
+    rtc_lastFullTelemetry = current;
+    rtc_hasFullTelemetry = true;
+    rtc_wakesSinceFullTelemetry = 0;
+  }
+  else if (rtc_wakesSinceFullTelemetry < 255)
+  {
+    rtc_wakesSinceFullTelemetry++;
+  }
+}
+
 } // namespace StateManager
@@ -10,6 +10,12 @@ namespace StateManager
 uint64_t getTimestamp();
 void setTimestamp(uint64_t ts);
 
+// Content hash of the displayed image (from X-Content-Hash), empty if unknown, and the render settings
+// (rotation, refresh mode) it was drawn with - the same image with other settings is still a change
+static const size_t CONTENT_HASH_MAX_LENGTH = 64;
+void setContentHash(const char *hash, uint16_t renderSettings = 0); // nullptr clears
+bool isContentUnchanged(const char *hash, uint16_t renderSettings);
+
 // WiFi failure tracking
 uint8_t getFailureCount();
 void incrementFailureCount();
@@ -34,6 +40,58 @@ unsigned long getLastDownloadDuration();
 unsigned long getLastRefreshDuration();
 void setLastRefreshDuration(unsigned long duration);
 
+// TLS handshake duration tracking (first connection of a wake, without DNS and TCP connect)
+unsigned long getLastHandshakeDuration();
+void setLastHandshakeDuration(unsigned long duration);
+
+// Network latency history for adaptive HTTP timeouts (moving averages in ms, 0 = no history yet).
+// First-byte latency only of responses with a rendered image, the timeout is a multiple of it.
+uint32_t getFirstByteLatency();
+void recordFirstByteLatency(uint32_t ms);
+uint32_t getReceiveGap();
+void recordReceiveGap(uint32_t ms);
+
+// Device capabilities measured in earlier wakes, reported to the server
+uint16_t getStreamingRows(); // Row buffer height direct streaming got, 0 if unknown
+void setStreamingRows(uint16_t rows);
+uint32_t getDownloadThroughput(); // Body bytes/s, moving average (0 = no history yet)
+void recordDownloadThroughput(uint32_t bytesPerSecond);
+
+// Network metrics of the last wake that downloaded an image, reported with the next request.
+// Times in ms; connect covers TCP connect plus TLS handshake (both happen inside the client's connect).
+struct DownloadMetrics
+{
+  static const uint8_t READ_SIZE_BUCKETS = 4; // Socket reads of <128, <512, <1024 and >=1024 bytes
+
+  uint32_t dnsMs;
+  uint32_t connectMs;
+  uint32_t firstByteMs;
+  uint32_t bodyMs;
+  uint32_t bytes;
+  uint32_t stallMs;
+  uint16_t stallCount;
+  uint16_t readSizes[READ_SIZE_BUCKETS];
+  uint8_t connections;
+  uint8_t requests;
+  bool reported;
+};
+
+const DownloadMetrics &getDownloadMetrics();
+void setDownloadMetrics(const DownloadMetrics &metrics);
+void markDownloadMetricsReported();
+
+// Telemetry values watched to decide between compact and full request payload
+struct TelemetrySnapshot
+{
+  int8_t rssi;
+  float voltage;
+  float temperature; // NAN without sensor
+};
+
+// Full telemetry is due every Nth wake, after a non deep sleep reset, or when a value moved past its threshold
+bool isFullTelemetryDue(const TelemetrySnapshot &current);
+void recordTelemetrySent(bool full, const TelemetrySnapshot &current);
+
 // Default sleep time
 static const uint64_t DEFAULT_SLEEP_SECONDS = 120;
 } // namespace StateManager
@@ -2,7 +2,10 @@
 #include "pixel_packer.h"
 
 #include "board.h"
+#include "http_client.h"
 #include "logger.h"
+#include "network_reader.h"
+#include "state_manager.h"
 #include "utils.h"
 
 #ifdef STREAMING_ENABLED
@@ -167,13 +170,9 @@ bool RowStreamBuffer::initDirect(uint16_t displayWidth, size_t rowCount, PixelPa
   // PNG decoder (pngle) needs: ~1KB base + width*4 for RGBA scanline + zlib state (~32KB) ≈ 40KB total
   // Z format (RLE) only needs a small HTTP buffer (512 bytes) + general overhead
   constexpr size_t PNG_DECODER_RESERVE = 40 * 1024; // 40KB for PNG decoder
-  // SSL/TLS (WiFiClientSecure) may allocate up to 16KB buffers during read operations,
-  // even after the handshake is complete. With HTTP (non-SSL), less reserve is needed.
-  #ifdef USE_CLIENT_HTTPS
-  constexpr size_t MIN_FREE_HEAP = 20 * 1024; // 20KB for SSL read buffers + general overhead
-  #else
-  constexpr size_t MIN_FREE_HEAP = 10 * 1024; // 10KB sufficient for plain HTTP
-  #endif
+  // HTTP client while reading (general overhead), plus the network reader's ring and task stack,
+  // allocated after the band by the format handlers
+  constexpr size_t MIN_FREE_HEAP = HttpClient::getReadHeapReserve() + NetworkReader::getHeapReserve();
 
   size_t memoryReserve = needsPngDecoder ? (PNG_DECODER_RESERVE + MIN_FREE_HEAP) : MIN_FREE_HEAP;
 
@@ -192,8 +191,9 @@ bool RowStreamBuffer::initDirect(uint16_t displayWidth, size_t rowCount, PixelPa
   constexpr size_t MIN_ROW_COUNT = 8;
 
   Logger::log<Logger::Level::DEBUG, Logger::Topic::STREAM>(
-    "Memory: heap={}, largest={}, reserve={} (png={}), max_alloc={}, bytes/row={} ({}x buf)\n", freeHeap, largestBlock,
-    memoryReserve, needsPngDecoder ? 1 : 0, maxBufferAllocation, totalBytesPerRow, buffersNeeded);
+    "Memory: heap={}, largest={}, reserve={} (http={}, png={}), max_alloc={}, bytes/row={} ({}x buf)\n", freeHeap,
+    largestBlock, memoryReserve, MIN_FREE_HEAP, needsPngDecoder ? 1 : 0, maxBufferAllocation, totalBytesPerRow,
+    buffersNeeded);
 
   if (maxAffordableRows < MIN_ROW_COUNT)
   {
@@ -330,6 +330,15 @@ const uint8_t *RowStreamBuffer::getRowData(size_t rowIndex) const
   return m_buffer.data() + rowOffset;
 }
 
+uint8_t *RowStreamBuffer::getRowDataMutable(size_t rowIndex)
+{
+  if (!m_initialized || rowIndex >= m_rowCount)
+    return nullptr;
+
+  size_t rowOffset = rowIndex * m_rowSize;
+  return m_buffer.data() + rowOffset;
+}
+
 void RowStreamBuffer::clear()
 {
   if (m_initialized)
@@ -353,6 +362,19 @@ void RowStreamBuffer::resetRow(size_t rowIndex)
   }
 }
 
+void RowStreamBuffer::copyRow(size_t srcIndex, size_t dstIndex)
+{
+  if (!m_initialized || srcIndex >= m_rowCount || dstIndex >= m_rowCount || srcIndex == dstIndex)
+    return;
+
+  memcpy(m_buffer.data() + dstIndex * m_rowSize, m_buffer.data() + srcIndex * m_rowSize, m_rowSize);
+  if (!m_colorBuffer.empty())
+    memcpy(m_colorBuffer.data() + dstIndex * m_rowSize, m_colorBuffer.data() + srcIndex * m_rowSize, m_rowSize);
+
+  m_rowWritePos[dstIndex] = m_rowWritePos[srcIndex];
+  m_rowPixelCount[dstIndex] = m_rowPixelCount[srcIndex];
+}
+
 const uint8_t *RowStreamBuffer::getColorRowData(size_t rowIndex) const
 {
   if (!m_initialized || rowIndex >= m_rowCount || m_colorBuffer.empty())
@@ -371,46 +393,6 @@ uint8_t *RowStreamBuffer::getColorRowDataMutable(size_t rowIndex)
   return m_colorBuffer.data() + rowOffset;
 }
 
-void RowStreamBuffer::setPixel(size_t rowIndex, uint16_t x, uint16_t color)
-{
-  if (!m_initialized || !m_directMode || rowIndex >= m_rowCount || x >= m_displayWidth)
-    return;
-
-  size_t rowOffset = rowIndex * m_rowSize;
-  uint8_t *rowData = m_buffer.data() + rowOffset;
-
-  switch (m_format)
-  {
-    case PixelPacker::DisplayFormat::BW:
-      PixelPacker::packPixelBW(rowData, x, color == 0x0000); // GxEPD_BLACK
-      break;
-
-    case PixelPacker::DisplayFormat::GRAYSCALE:
-      PixelPacker::packPixel4G(rowData, x, PixelPacker::gxepdToGrey(color));
-      break;
-
-    case PixelPacker::DisplayFormat::COLOR_3C:
-    {
-      uint8_t *colorData = m_colorBuffer.data() + rowOffset;
-      PixelPacker::packPixel3C(rowData, colorData, x, color);
-    }
-    break;
-
-    case PixelPacker::DisplayFormat::COLOR_7C:
-      PixelPacker::packPixel7C(rowData, x, PixelPacker::gxepdTo7CColor(color));
-      break;
-
-    case PixelPacker::DisplayFormat::COLOR_4C:
-      PixelPacker::packPixel4C(rowData, x, PixelPacker::gxepdTo4CColor(color));
-      break;
-
-    default:
-      break;
-  }
-
-  incrementRowPixelCount(rowIndex);
-}
-
 void RowStreamBuffer::setPixelGrey(size_t rowIndex, uint16_t x, uint8_t grey)
 {
   if (!m_initialized || !m_directMode || rowIndex >= m_rowCount || x >= m_displayWidth)
@@ -427,52 +409,6 @@ void RowStreamBuffer::setPixelGrey(size_t rowIndex, uint16_t x, uint8_t grey)
   incrementRowPixelCount(rowIndex);
 }
 
-void RowStreamBuffer::fillPixelRun(size_t rowIndex, uint16_t startX, uint16_t count, uint16_t color)
-{
-  if (!m_initialized || !m_directMode || rowIndex >= m_rowCount || count == 0)
-    return;
-  if (startX >= m_displayWidth)
-    return;
-
-  // Clip run to row width
-  if (startX + count > m_displayWidth)
-    count = m_displayWidth - startX;
-
-  size_t rowOffset = rowIndex * m_rowSize;
-  uint8_t *rowData = m_buffer.data() + rowOffset;
-
-  switch (m_format)
-  {
-    case PixelPacker::DisplayFormat::BW:
-      PixelPacker::fillPixelRunBW(rowData, startX, count, color == 0x0000u); // GxEPD_BLACK
-      break;
-
-    case PixelPacker::DisplayFormat::GRAYSCALE:
-      PixelPacker::fillPixelRunGrayscale(rowData, startX, count, PixelPacker::gxepdToGrey(color));
-      break;
-
-    case PixelPacker::DisplayFormat::COLOR_3C:
-    {
-      uint8_t *colorData = m_colorBuffer.data() + rowOffset;
-      PixelPacker::fillPixelRun3C(rowData, colorData, startX, count, color);
-    }
-    break;
-
-    case PixelPacker::DisplayFormat::COLOR_7C:
-      PixelPacker::fillPixelRun7C(rowData, startX, count, PixelPacker::gxepdTo7CColor(color));
-      break;
-
-    case PixelPacker::DisplayFormat::COLOR_4C:
-      PixelPacker::fillPixelRun4C(rowData, startX, count, PixelPacker::gxepdTo4CColor(color));
-      break;
-
-    default:
-      break;
-  }
-
-  m_rowPixelCount[rowIndex] += count;
-}
-
 void RowStreamBuffer::clearRow(size_t rowIndex)
 {
   if (!m_initialized || rowIndex >= m_rowCount)
@@ -559,6 +495,9 @@ bool StreamingManager::initDirect(uint16_t displayWidth, size_t rowCount, bool n
     return false;
   }
 
+  // Reported to the server with the next request, so it can size its bands to what fits here
+  StateManager::setStreamingRows(m_buffer->getRowCount());
+
   Logger::log<Logger::Level::INFO, Logger::Topic::STREAM>("Manager initialized in direct mode\n");
   return true;
 }
@@ -51,6 +51,7 @@ public:
   size_t writeRow(size_t rowIndex, const uint8_t *data, size_t length);
 
   const uint8_t *getRowData(size_t rowIndex) const;
+  uint8_t *getRowDataMutable(size_t rowIndex);
   size_t getRowSize() const { return m_rowSize; }
   size_t getRowCount() const { return m_rowCount; }
   // Check if color buffer is allocated (for 3C displays)
@@ -67,11 +68,35 @@ public:
   uint8_t *getColorRowDataMutable(size_t rowIndex);
 
   // Direct pixel packing methods
-  void setPixel(size_t rowIndex, uint16_t x, uint16_t color);
   void setPixelGrey(size_t rowIndex, uint16_t x, uint8_t grey);
-  // Bulk fill: write a run of identical pixels starting at (rowIndex, startX).
-  // Significantly faster than calling setPixel per pixel for RLE formats.
-  void fillPixelRun(size_t rowIndex, uint16_t startX, uint16_t count, uint16_t color);
+
+  // Set one pixel to a native code from PixelPacker::NATIVE_PALETTE, no checks and no format switch.
+  // Direct mode only, the caller keeps x inside the row.
+  void setNativePixel(size_t rowIndex, uint16_t x, uint8_t code)
+  {
+    size_t rowOffset = rowIndex * m_rowSize;
+  #ifdef TYPE_3C
+    PixelPacker::packNativePixel<1>(m_buffer.data() + rowOffset, x, code & 0x01);
+    PixelPacker::packNativePixel<1>(m_colorBuffer.data() + rowOffset, x, code >> 1);
+  #else
+    PixelPacker::packNativePixel<PixelPacker::NATIVE_BITS_PER_PIXEL>(m_buffer.data() + rowOffset, x, code);
+  #endif
+    incrementRowPixelCount(rowIndex);
+  }
+
+  // Bulk fill: write a run of identical pixels starting at (rowIndex, startX), pattern from
+  // PixelPacker::RUN_PATTERNS. Significantly faster than setting pixels one by one for RLE formats.
+  // Direct mode only, the caller keeps the run inside the row.
+  void fillNativeRun(size_t rowIndex, uint16_t startX, uint16_t count, uint16_t pattern)
+  {
+    size_t rowOffset = rowIndex * m_rowSize;
+    PixelPacker::fillPackedRun<PixelPacker::NATIVE_BITS_PER_PIXEL>(m_buffer.data() + rowOffset, startX, count,
+                                                                   (uint8_t)pattern);
+  #ifdef TYPE_3C
+    PixelPacker::fillPackedRun<1>(m_colorBuffer.data() + rowOffset, startX, count, (uint8_t)(pattern >> 8));
+  #endif
+    m_rowPixelCount[rowIndex] += count;
+  }
 
   // Row management
   void clearRow(size_t rowIndex);
@@ -81,6 +106,8 @@ public:
 
   void clear();
   void resetRow(size_t rowIndex);
+  // Copy a packed row (both planes for 3C) with its pixel count, for row-repeat opcodes
+  void copyRow(size_t srcIndex, size_t dstIndex);
 
   bool isInitialized() const { return m_initialized; }
   bool isDirectMode() const { return m_directMode; }
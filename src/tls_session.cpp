@@ -0,0 +1,136 @@
+#include "tls_session.h"
+
+#include "logger.h"
+
+#include <mbedtls/ssl.h>
+#include <time.h>
+
+namespace TlsSession
+{
+
+#ifdef TLS_SESSION_CACHE_ENABLED
+// Session saved with mbedtls_ssl_session_save, the save time comes from the system clock (runs through deep sleep)
+struct SessionCache
+{
+  uint32_t hostHash;
+  time_t savedAt;
+  uint16_t length;
+  uint8_t data[TLS_SESSION_CACHE_SIZE];
+
+  bool isValid(uint32_t hash, time_t now) const
+  {
+    return length > 0 && hostHash == hash && now >= savedAt && now - savedAt < TLS_SESSION_MAX_AGE_SECONDS;
+  }
+};
+
+RTC_DATA_ATTR static SessionCache rtc_session = {};
+#endif
+
+// Handshake being watched, set by arm() and picked up by the mbedtls_ssl_set_hostname wrapper
+static bool s_armed = false;
+static uint32_t s_hostHash = 0;
+static mbedtls_ssl_context *s_ssl = nullptr;
+static uint32_t s_tlsStart = 0;
+static bool s_offered = false;
+
+#ifdef TLS_SESSION_CACHE_ENABLED
+static bool offerSession(mbedtls_ssl_context *ssl)
+{
+  if (!rtc_session.isValid(s_hostHash, time(nullptr)))
+    return false;
+
+  // mbedtls_ssl_set_session keeps its own copy
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  bool offered = mbedtls_ssl_session_load(&session, rtc_session.data, rtc_session.length) == 0 &&
+                 mbedtls_ssl_set_session(ssl, &session) == 0;
+  mbedtls_ssl_session_free(&session);
+
+  if (!offered)
+    rtc_session.length = 0;
+  return offered;
+}
+
+static void storeSession(mbedtls_ssl_context *ssl)
+{
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+
+  size_t length = 0;
+  int ret = mbedtls_ssl_get_session(ssl, &session);
+  if (ret == 0)
+    ret = mbedtls_ssl_session_save(&session, rtc_session.data, sizeof(rtc_session.data), &length);
+  mbedtls_ssl_session_free(&session);
+
+  if (ret != 0)
+  {
+    rtc_session.length = 0;
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL)
+      Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>(
+        "TLS session needs {} bytes, larger than TLS_SESSION_CACHE_SIZE\n", length);
+    return;
+  }
+
+  rtc_session.hostHash = s_hostHash;
+  rtc_session.savedAt = time(nullptr);
+  rtc_session.length = length;
+}
+#endif
+
+void arm(uint32_t hostHash)
+{
+  s_armed = true;
+  s_hostHash = hostHash;
+  s_ssl = nullptr;
+  s_tlsStart = 0;
+  s_offered = false;
+}
+
+uint32_t finish(bool connected)
+{
+  s_armed = false;
+  if (!s_ssl)
+    return 0;
+
+  uint32_t duration = millis() - s_tlsStart;
+
+#ifdef TLS_SESSION_CACHE_ENABLED
+  if (connected)
+  {
+    storeSession(s_ssl);
+  }
+  else if (s_offered)
+  {
+    // Not the usual outcome of a stale session (that is a full handshake), but don't offer it again
+    rtc_session.length = 0;
+  }
+#endif
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("TLS handshake {} ms{}\n", duration,
+                                                         s_offered ? ", cached session offered" : "");
+
+  // The SSL context belongs to the client, it is freed with the connection
+  s_ssl = nullptr;
+  return duration;
+}
+
+} // namespace TlsSession
+
+// Linker wrap (-Wl,--wrap=mbedtls_ssl_set_hostname): WiFiClientSecure calls this after the TCP connect and
+// mbedTLS setup, right before the handshake. Passes through unless a handshake is armed.
+extern "C" int __real_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname);
+
+extern "C" int __wrap_mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname)
+{
+  int ret = __real_mbedtls_ssl_set_hostname(ssl, hostname);
+  if (ret != 0 || !TlsSession::s_armed)
+    return ret;
+
+  TlsSession::s_armed = false;
+  TlsSession::s_ssl = ssl;
+  TlsSession::s_tlsStart = millis();
+#ifdef TLS_SESSION_CACHE_ENABLED
+  TlsSession::s_offered = TlsSession::offerSession(ssl);
+#endif
+  return ret;
+}
@@ -0,0 +1,34 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+// TLS session resumption across deep sleep - HTTPS builds, disable with -D TLS_SESSION_CACHE_DISABLED.
+// The session of the last handshake is kept in RTC memory and offered on the next connect, a server that still
+// knows it (session ID cache or ticket) answers with the abbreviated handshake: no certificate, no key exchange.
+// WiFiClientSecure runs the whole handshake inside connect(), so the session is handed to mbedTLS from a linker
+// wrap of mbedtls_ssl_set_hostname, its last call before the handshake (see scripts/tls_session_wrap.py).
+#if !defined(USE_CLIENT_HTTP) && !defined(TLS_SESSION_CACHE_DISABLED)
+  #define TLS_SESSION_CACHE_ENABLED
+
+  #ifndef TLS_SESSION_CACHE_SIZE
+    #define TLS_SESSION_CACHE_SIZE 2048 // Serialized session, includes the server certificate
+  #endif
+  #ifndef TLS_SESSION_MAX_AGE_SECONDS
+    #define TLS_SESSION_MAX_AGE_SECONDS 86400 // Servers usually forget sessions sooner, they just do a full handshake
+  #endif
+#endif
+
+#include <Arduino.h>
+
+namespace TlsSession
+{
+
+// Watch the next handshake: offer the cached session for hostHash and time the TLS phase
+void arm(uint32_t hostHash);
+
+// Call right after connect() returned. Stores the negotiated session when connected and returns the
+// TLS phase duration in ms (handshake only, without DNS and TCP connect), 0 if no handshake was seen.
+uint32_t finish(bool connected);
+
+} // namespace TlsSession
+
+#endif // TLS_SESSION_H
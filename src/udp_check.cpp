@@ -0,0 +1,173 @@
+#include "udp_check.h"
+
+#ifdef USE_UDP_CHECK
+
+  #include "logger.h"
+  #include "utils.h"
+
+  #include <WiFi.h>
+  #include <WiFiUdp.h>
+  #include <esp_random.h>
+  #include <mbedtls/md.h>
+
+namespace UdpCheck
+{
+
+// Datagram layout, all integers little endian:
+//   request: magic "ZO", version, type 1, nonce u32, MAC[6], timestamp u64, vcc mV u16, RSSI i8, reserved u8, tag
+//   reply:   magic "ZO", version, type 2, nonce u32, flags u8, reserved u8[3], timestamp u64, sleep s u32, tag
+// tag = first 16 bytes of HMAC-SHA256 over everything before it, keyed with the API key in decimal
+// (the X-API-Key value). The key itself is never sent, the MAC tells the server which key to use.
+static constexpr uint8_t MAGIC_0 = 'Z';
+static constexpr uint8_t MAGIC_1 = 'O';
+static constexpr uint8_t VERSION = 1;
+static constexpr uint8_t TYPE_REQUEST = 1;
+static constexpr uint8_t TYPE_REPLY = 2;
+static constexpr uint8_t FLAG_HTTPS_REQUIRED = 0x01;
+
+static constexpr size_t TAG_SIZE = 16;
+static constexpr size_t REQUEST_SIZE = 26 + TAG_SIZE;
+static constexpr size_t REPLY_SIZE = 24 + TAG_SIZE;
+
+static void putLE(uint8_t *out, uint64_t value, uint8_t bytes)
+{
+  for (uint8_t i = 0; i < bytes; i++)
+    out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t getLE(const uint8_t *in, uint8_t bytes)
+{
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < bytes; i++)
+    value |= (uint64_t)in[i] << (8 * i);
+  return value;
+}
+
+static bool computeTag(const uint8_t *data, size_t length, uint8_t *tag)
+{
+  char key[11];
+  snprintf(key, sizeof(key), "%lu", (unsigned long)Utils::getStoredAPIKey());
+
+  uint8_t digest[32];
+  const mbedtls_md_info_t *sha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+  if (mbedtls_md_hmac(sha256, (const uint8_t *)key, strlen(key), data, length, digest) != 0)
+    return false;
+
+  memcpy(tag, digest, TAG_SIZE);
+  return true;
+}
+
+// Constant time, a forged reply learns nothing from how fast it was rejected
+static bool tagMatches(const uint8_t *a, const uint8_t *b)
+{
+  uint8_t diff = 0;
+  for (size_t i = 0; i < TAG_SIZE; i++)
+    diff |= a[i] ^ b[i];
+  return diff == 0;
+}
+
+static size_t buildRequest(uint8_t *out, uint32_t nonce, uint64_t storedTimestamp,
+                           const StateManager::TelemetrySnapshot &telemetry)
+{
+  out[0] = MAGIC_0;
+  out[1] = MAGIC_1;
+  out[2] = VERSION;
+  out[3] = TYPE_REQUEST;
+  putLE(out + 4, nonce, 4);
+  WiFi.macAddress(out + 8);
+  putLE(out + 14, storedTimestamp, 8);
+  putLE(out + 22, (telemetry.voltage > 0) ? (uint16_t)(telemetry.voltage * 1000) : 0, 2);
+  out[24] = (uint8_t)telemetry.rssi;
+  out[25] = 0;
+
+  if (!computeTag(out, REQUEST_SIZE - TAG_SIZE, out + REQUEST_SIZE - TAG_SIZE))
+    return 0;
+  return REQUEST_SIZE;
+}
+
+static bool parseReply(const uint8_t *in, size_t length, uint32_t nonce, Reply &reply)
+{
+  if (length != REPLY_SIZE || in[0] != MAGIC_0 || in[1] != MAGIC_1 || in[2] != VERSION || in[3] != TYPE_REPLY)
+    return false;
+
+  // Nonce ties the reply to this request, a replayed older one doesn't match
+  if (getLE(in + 4, 4) != nonce)
+    return false;
+
+  uint8_t tag[TAG_SIZE];
+  if (!computeTag(in, REPLY_SIZE - TAG_SIZE, tag) || !tagMatches(tag, in + REPLY_SIZE - TAG_SIZE))
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("UDP check: reply with invalid tag ignored\n");
+    return false;
+  }
+
+  reply.httpsRequired = in[8] & FLAG_HTTPS_REQUIRED;
+  reply.timestamp = getLE(in + 12, 8);
+  reply.sleepSeconds = getLE(in + 20, 4);
+  return true;
+}
+
+bool query(const IPAddress &server, uint64_t storedTimestamp, const StateManager::TelemetrySnapshot &telemetry,
+           Reply &reply)
+{
+  uint32_t nonce = esp_random();
+  uint8_t request[REQUEST_SIZE];
+  size_t requestLength = buildRequest(request, nonce, storedTimestamp, telemetry);
+  if (requestLength == 0)
+    return false;
+
+  WiFiUDP udp;
+  if (!udp.begin(0))
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("UDP check: no socket\n");
+    return false;
+  }
+
+  bool received = false;
+  uint32_t start = millis();
+
+  for (uint8_t attempt = 0; attempt < UDP_CHECK_ATTEMPTS && !received; attempt++)
+  {
+    udp.beginPacket(server, UDP_CHECK_PORT);
+    udp.write(request, requestLength);
+    if (!udp.endPacket())
+      break;
+
+    uint32_t sent = millis();
+    while (millis() - sent < UDP_CHECK_TIMEOUT_MS)
+    {
+      int size = udp.parsePacket();
+      if (size <= 0)
+      {
+        delay(2);
+        continue;
+      }
+
+      uint8_t buffer[REPLY_SIZE];
+      int length = udp.read(buffer, sizeof(buffer));
+      if (udp.remoteIP() == server && udp.remotePort() == UDP_CHECK_PORT && size == length &&
+          parseReply(buffer, length, nonce, reply))
+      {
+        received = true;
+        break;
+      }
+    }
+  }
+
+  udp.stop();
+
+  if (!received)
+  {
+    Logger::log<Logger::Level::WARNING, Logger::Topic::HTTP>("UDP check: no reply from {} after {} ms\n",
+                                                             server.toString(), millis() - start);
+    return false;
+  }
+
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::HTTP>("UDP check: reply in {} ms, timestamp {}\n",
+                                                         millis() - start, reply.timestamp);
+  return true;
+}
+
+} // namespace UdpCheck
+
+#endif // USE_UDP_CHECK
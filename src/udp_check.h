@@ -0,0 +1,44 @@
+#ifndef UDP_CHECK_H
+#define UDP_CHECK_H
+
+// Lightweight timestamp check over UDP - disabled by default, enable with -D USE_UDP_CHECK.
+// One authenticated datagram each way replaces TCP + TLS + HTTP on wakes where nothing changed,
+// HTTPS is used when the content changed, the server asks for it, or no valid reply arrives.
+// See scripts/udp_check_server.py for the packet format and a local stand-in server.
+#ifdef USE_UDP_CHECK
+
+  #ifndef UDP_CHECK_PORT
+    #define UDP_CHECK_PORT 5683
+  #endif
+  #ifndef UDP_CHECK_TIMEOUT_MS
+    #define UDP_CHECK_TIMEOUT_MS 800 // Per attempt
+  #endif
+  #ifndef UDP_CHECK_ATTEMPTS
+    #define UDP_CHECK_ATTEMPTS 2
+  #endif
+
+  #include <Arduino.h>
+  #include <IPAddress.h>
+
+  #include "state_manager.h"
+
+namespace UdpCheck
+{
+
+struct Reply
+{
+  uint64_t timestamp;
+  uint32_t sleepSeconds; // 0 if the server has no preference
+  bool httpsRequired;    // Server wants the full HTTPS exchange (settings, OTA, ...)
+};
+
+// Send the stored timestamp and compact telemetry, wait for the authenticated reply.
+// Returns false on timeout or when no valid reply arrived.
+bool query(const IPAddress &server, uint64_t storedTimestamp, const StateManager::TelemetrySnapshot &telemetry,
+           Reply &reply);
+
+} // namespace UdpCheck
+
+#endif // USE_UDP_CHECK
+
+#endif // UDP_CHECK_H
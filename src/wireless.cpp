@@ -287,6 +287,34 @@ String getIPAddress() { return WiFi.localIP().toString(); }
 
 bool isConnected() { return WiFi.status() == WL_CONNECTED; }
 
+// Arduino-ESP32 already runs the station in WIFI_PS_MIN_MODEM (radio wakes for every DTIM beacon).
+// Download power save goes one step further to WIFI_PS_MAX_MODEM, which wakes only every listen interval,
+// and puts back whatever mode was active before.
+static wifi_ps_type_t s_savedPowerSave = WIFI_PS_MIN_MODEM;
+static bool s_downloadPowerSave = false;
+
+bool setDownloadPowerSave(bool enable)
+{
+  if (enable == s_downloadPowerSave)
+    return s_downloadPowerSave;
+
+  if (enable)
+  {
+    if (esp_wifi_get_ps(&s_savedPowerSave) != ESP_OK || s_savedPowerSave == WIFI_PS_MAX_MODEM ||
+        esp_wifi_set_ps(WIFI_PS_MAX_MODEM) != ESP_OK)
+      return false; // Nothing to gain, or not possible
+  }
+  else
+  {
+    esp_wifi_set_ps(s_savedPowerSave);
+  }
+
+  s_downloadPowerSave = enable;
+  Logger::log<Logger::Level::DEBUG, Logger::Topic::WIFI>("Download power save {} (default mode {})\n",
+                                                         enable ? "on" : "off", (int)s_savedPowerSave);
+  return s_downloadPowerSave;
+}
+
 void turnOff()
 {
   WiFi.disconnect(true);
@@ -22,6 +22,9 @@ String getSoftAPIP();
 String getIPAddress();
 
 bool isConnected();
+// Max modem sleep while a download runs, false restores the previous power save mode.
+// Returns whether download power save is active.
+bool setDownloadPowerSave(bool enable);
 void turnOff();
 void resetCredentialsAndReboot();
 } // namespace Wireless